@@ -167,6 +167,7 @@ static int restore_tty;
 
 #if HAVE_THREADS
 static void free_input_threads(void);
+static void free_output_threads(void);
 #endif
 
 /* sub2video hack:
@@ -568,6 +569,10 @@ static void ffmpeg_cleanup(int ret)
 
     av_freep(&subtitle_out);
 
+#if HAVE_THREADS
+    free_output_threads();
+#endif
+
     /* close files */
     for (i = 0; i < nb_output_files; i++) {
         OutputFile *of = output_files[i];
@@ -653,6 +658,7 @@ static void ffmpeg_cleanup(int ret)
                    av_err2str(AVERROR(errno)));
     }
     av_freep(&vstats_filename);
+    av_freep(&filter_thread_type);
 
     av_freep(&input_streams);
     av_freep(&input_files);
@@ -726,6 +732,115 @@ static void close_all_output_streams(OutputStream *ost, OSTFinished this_stream,
     }
 }
 
+#if HAVE_THREADS
+static void *mux_thread(void *arg)
+{
+    OutputFile *of = arg;
+    AVFormatContext *s = of->ctx;
+    AVPacket *pkt;
+    int ret;
+
+    while (1) {
+        ret = av_thread_message_queue_recv(of->mux_thread_queue, &pkt, 0);
+        if (ret < 0)
+            break;
+
+        ret = av_interleaved_write_frame(s, pkt);
+        av_packet_free(&pkt);
+        if (ret < 0) {
+            print_error("av_interleaved_write_frame()", ret);
+            of->mux_thread_ret = ret;
+            av_thread_message_queue_set_err_send(of->mux_thread_queue, ret);
+            break;
+        }
+        if (s->pb)
+            atomic_store(&of->last_filesize, avio_tell(s->pb));
+    }
+
+    return NULL;
+}
+
+static void free_output_thread(int i)
+{
+    OutputFile *of = output_files[i];
+    AVPacket *pkt;
+
+    if (!of || !of->mux_thread_queue)
+        return;
+    /* let the thread write out what has been queued so far, then stop it */
+    av_thread_message_queue_set_err_recv(of->mux_thread_queue, AVERROR_EOF);
+    pthread_join(of->mux_thread, NULL);
+    while (av_thread_message_queue_recv(of->mux_thread_queue, &pkt, 0) >= 0)
+        av_packet_free(&pkt);
+    av_thread_message_queue_free(&of->mux_thread_queue);
+
+    if (of->mux_thread_ret < 0)
+        main_return_code = 1;
+}
+
+static void free_output_threads(void)
+{
+    int i;
+
+    for (i = 0; i < nb_output_files; i++)
+        free_output_thread(i);
+}
+
+static int init_output_thread(OutputFile *of)
+{
+    int ret;
+
+    if (of->thread_queue_size < 0)
+        of->thread_queue_size = (nb_output_files > 1 ? 8 : 0);
+    if (!of->thread_queue_size)
+        return 0;
+
+    ret = av_thread_message_queue_alloc(&of->mux_thread_queue,
+                                        of->thread_queue_size, sizeof(AVPacket *));
+    if (ret < 0)
+        return ret;
+    atomic_init(&of->last_filesize, of->ctx->pb ? avio_tell(of->ctx->pb) : 0);
+
+    if ((ret = pthread_create(&of->mux_thread, NULL, mux_thread, of))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        av_thread_message_queue_free(&of->mux_thread_queue);
+        return AVERROR(ret);
+    }
+
+    return 0;
+}
+
+static int write_packet_mt(OutputFile *of, AVPacket *pkt)
+{
+    AVPacket *queue_pkt;
+    int ret;
+
+    ret = av_packet_make_refcounted(pkt);
+    if (ret < 0)
+        return ret;
+    queue_pkt = av_packet_alloc();
+    if (!queue_pkt)
+        return AVERROR(ENOMEM);
+    av_packet_move_ref(queue_pkt, pkt);
+
+    /* blocks while the queue is full, throttling the producers */
+    ret = av_thread_message_queue_send(of->mux_thread_queue, &queue_pkt, 0);
+    if (ret < 0)
+        av_packet_free(&queue_pkt);
+    return ret;
+}
+#endif
+
+/* Return the number of bytes written to the output file so far. */
+static int64_t of_filesize(OutputFile *of)
+{
+#if HAVE_THREADS
+    if (of->mux_thread_queue)
+        return atomic_load(&of->last_filesize);
+#endif
+    return of->ctx->pb ? avio_tell(of->ctx->pb) : -1;
+}
+
 static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int unqueue)
 {
     AVFormatContext *s = of->ctx;
@@ -863,9 +978,19 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
               );
     }
 
-    ret = av_interleaved_write_frame(s, pkt);
+#if HAVE_THREADS
+    if (of->mux_thread_queue) {
+        ret = write_packet_mt(of, pkt);
+        if (ret < 0 && ret != of->mux_thread_ret)
+            print_error("av_thread_message_queue_send()", ret);
+    } else
+#endif
+    {
+        ret = av_interleaved_write_frame(s, pkt);
+        if (ret < 0)
+            print_error("av_interleaved_write_frame()", ret);
+    }
     if (ret < 0) {
-        print_error("av_interleaved_write_frame()", ret);
         main_return_code = 1;
         close_all_output_streams(ost, MUXER_FINISHED | ENCODER_FINISHED, ENCODER_FINISHED);
     }
@@ -1735,10 +1860,17 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
 
 
     oc = output_files[0]->ctx;
-
-    total_size = avio_size(oc->pb);
-    if (total_size <= 0) // FIXME improve avio_size() so it works with non seekable output too
-        total_size = avio_tell(oc->pb);
+#if HAVE_THREADS
+    /* the muxer thread owns the AVIOContext */
+    if (output_files[0]->mux_thread_queue) {
+        total_size = of_filesize(output_files[0]);
+    } else
+#endif
+    {
+        total_size = avio_size(oc->pb);
+        if (total_size <= 0) // FIXME improve avio_size() so it works with non seekable output too
+            total_size = avio_tell(oc->pb);
+    }
 
     vid = 0;
     av_bprint_init(&buf, 0, AV_BPRINT_SIZE_AUTOMATIC);
@@ -2936,14 +3068,86 @@ static enum AVPixelFormat get_format(AVCodecContext *s, const enum AVPixelFormat
     return *p;
 }
 
+static void print_filter_profile(void)
+{
+    int i, j;
+
+    for (i = 0; i < nb_filtergraphs; i++) {
+        AVFilterGraph *graph = filtergraphs[i]->graph;
+        int64_t total_time = 0;
+
+        if (!graph)
+            continue;
+
+        for (j = 0; j < graph->nb_filters; j++) {
+            AVFilterProfile p;
+            if (avfilter_get_profile(graph->filters[j], &p) >= 0)
+                total_time += p.wall_time;
+        }
+
+        av_log(NULL, AV_LOG_INFO, "Filter profile for filtergraph #%d:\n", i);
+        av_log(NULL, AV_LOG_INFO, "  %-32s %10s %10s %6s %10s %10s %10s %7s %7s\n",
+               "filter", "runs", "wall (ms)", "%", "cpu (ms)",
+               "frames in", "frames out", "queued", "max");
+        for (j = 0; j < graph->nb_filters; j++) {
+            AVFilterContext *f = graph->filters[j];
+            AVFilterProfile p;
+            char cpu[32] = "-";
+
+            if (avfilter_get_profile(f, &p) < 0)
+                continue;
+            if (p.cpu_time >= 0)
+                snprintf(cpu, sizeof(cpu), "%.3f", p.cpu_time / 1000.0);
+            av_log(NULL, AV_LOG_INFO,
+                   "  %-32s %10"PRId64" %10.3f %6.2f %10s %10"PRId64" %10"PRId64" %7"PRId64" %7"PRId64"\n",
+                   f->name, p.nb_activations, p.wall_time / 1000.0,
+                   total_time ? 100.0 * p.wall_time / total_time : 0.0, cpu,
+                   p.frames_in, p.frames_out, p.queued, p.max_queued);
+        }
+    }
+}
+
 static int get_buffer(AVCodecContext *s, AVFrame *frame, int flags)
 {
     InputStream *ist = s->opaque;
 
+    const AVPixFmtDescriptor *desc;
+    int extra_width, extra_top, extra_bottom, width, height, i, ret;
+
     if (ist->hwaccel_get_buffer && frame->format == ist->hwaccel_pix_fmt)
         return ist->hwaccel_get_buffer(s, frame, flags);
 
-    return avcodec_default_get_buffer2(s, frame, flags);
+    extra_width  = atomic_load(&ist->headroom_width);
+    extra_top    = atomic_load(&ist->headroom_top);
+    extra_bottom = atomic_load(&ist->headroom_bottom);
+    desc = av_pix_fmt_desc_get(frame->format);
+    if (s->codec_type != AVMEDIA_TYPE_VIDEO || s->hw_frames_ctx || !desc ||
+        desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL |
+                       AV_PIX_FMT_FLAG_BITSTREAM) ||
+        !(extra_width | extra_top | extra_bottom) ||
+        frame->width  > INT_MAX - extra_width ||
+        frame->height > INT_MAX - extra_top - extra_bottom - 16)
+        return avcodec_default_get_buffer2(s, frame, flags);
+
+    /* keep the picture aligned on a chroma line */
+    extra_top = FFALIGN(extra_top, 1 << desc->log2_chroma_h);
+
+    width  = frame->width;
+    height = frame->height;
+    frame->width  += extra_width;
+    frame->height += extra_top + extra_bottom;
+    ret = avcodec_default_get_buffer2(s, frame, flags);
+    frame->width  = width;
+    frame->height = height;
+    if (ret < 0)
+        return ret;
+
+    for (i = 0; i < 4 && frame->data[i]; i++) {
+        int vsub = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+        frame->data[i] += (extra_top >> vsub) * frame->linesize[i];
+    }
+
+    return 0;
 }
 
 static int init_input_stream(int ist_index, char *error, int error_len)
@@ -3054,6 +3258,12 @@ static int check_init_output_file(OutputFile *of, int file_index)
     if (sdp_filename || want_sdp)
         print_sdp();
 
+#if HAVE_THREADS
+    ret = init_output_thread(of);
+    if (ret < 0)
+        return ret;
+#endif
+
     /* flush the muxing queues */
     for (i = 0; i < of->ctx->nb_streams; i++) {
         OutputStream *ost = output_streams[of->ost_index + i];
@@ -3915,10 +4125,9 @@ static int need_output(void)
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost    = output_streams[i];
         OutputFile *of       = output_files[ost->file_index];
-        AVFormatContext *os  = output_files[ost->file_index]->ctx;
 
         if (ost->finished ||
-            (os->pb && avio_tell(os->pb) >= of->limit_filesize))
+            (of->ctx->pb && of_filesize(of) >= of->limit_filesize))
             continue;
         if (ost->frame_number >= ost->max_frames) {
             int j;
@@ -4824,6 +5033,10 @@ static int transcode(void)
     }
     flush_encoders();
 
+#if HAVE_THREADS
+    free_output_threads();
+#endif
+
     term_exit();
 
     /* write the trailer if needed and close file */
@@ -4846,6 +5059,9 @@ static int transcode(void)
     /* dump report by using the first video and audio streams */
     print_report(1, timer_start, av_gettime_relative());
 
+    if (do_filter_profile)
+        print_filter_profile();
+
     /* close each encoder */
     for (i = 0; i < nb_output_streams; i++) {
         ost = output_streams[i];
@@ -4882,6 +5098,7 @@ static int transcode(void)
  fail:
 #if HAVE_THREADS
     free_input_threads();
+    free_output_threads();
 #endif
 
     if (output_streams) {
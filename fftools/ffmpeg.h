@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <signal.h>
@@ -367,6 +368,13 @@ typedef struct InputStream {
 
     int reinit_filters;
 
+    /* padding around decoded pictures requested by the filtergraph, so that
+     * it can pad them in place; written by the main thread, read from
+     * get_buffer() */
+    atomic_int headroom_width;
+    atomic_int headroom_top;
+    atomic_int headroom_bottom;
+
     /* hwaccel options */
     enum HWAccelID hwaccel_id;
     enum AVHWDeviceType hwaccel_device_type;
@@ -583,6 +591,15 @@ typedef struct OutputFile {
     int shortest;
 
     int header_written;
+
+#if HAVE_THREADS
+    AVThreadMessageQueue *mux_thread_queue;
+    pthread_t mux_thread;       /* thread writing packets to this file */
+    int mux_thread_ret;         /* error returned by the muxer, set by the thread */
+    int thread_queue_size;      /* maximum number of queued packets */
+    /* bytes written so far, updated by the thread after each packet */
+    atomic_int_least64_t last_filesize;
+#endif
 } OutputFile;
 
 extern InputStream **input_streams;
@@ -611,6 +628,7 @@ extern int video_sync_method;
 extern float frame_drop_threshold;
 extern int do_benchmark;
 extern int do_benchmark_all;
+extern int do_filter_profile;
 extern int do_deinterlace;
 extern int do_hex_dump;
 extern int do_pkt_dump;
@@ -631,6 +649,7 @@ extern char *videotoolbox_pixfmt;
 
 extern int filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern char *filter_thread_type;
 extern int vstats_version;
 extern int auto_conversion_filters;
 
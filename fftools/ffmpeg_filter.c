@@ -990,6 +990,7 @@ int configure_filtergraph(FilterGraph *fg)
     cleanup_filtergraph(fg);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    fg->graph->profile = do_filter_profile;
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
@@ -1031,6 +1032,10 @@ int configure_filtergraph(FilterGraph *fg)
         fg->graph->nb_threads = filter_complex_nbthreads;
     }
 
+    if (filter_thread_type &&
+        (ret = av_opt_set(fg->graph, "thread_type", filter_thread_type, 0)) < 0)
+        goto fail;
+
     if ((ret = avfilter_graph_parse2(fg->graph, graph_desc, &inputs, &outputs)) < 0)
         goto fail;
 
@@ -1096,6 +1101,22 @@ int configure_filtergraph(FilterGraph *fg)
         ofilter->channel_layout = av_buffersink_get_channel_layout(sink);
     }
 
+    /* let the decoders allocate room for in-place padding, unless their
+     * frames are shared between several filters */
+    for (i = 0; i < fg->nb_inputs; i++) {
+        InputFilter *ifilter = fg->inputs[i];
+        InputStream *ist = ifilter->ist;
+        int extra_width = 0, extra_top = 0, extra_bottom = 0;
+
+        if (ifilter->type == AVMEDIA_TYPE_VIDEO && ist->nb_filters == 1 &&
+            av_buffersrc_get_headroom(ifilter->filter, &extra_width,
+                                      &extra_top, &extra_bottom) < 0)
+            extra_width = extra_top = extra_bottom = 0;
+        atomic_store(&ist->headroom_width,  extra_width);
+        atomic_store(&ist->headroom_top,    extra_top);
+        atomic_store(&ist->headroom_bottom, extra_bottom);
+    }
+
     fg->reconfiguration = 1;
 
     for (i = 0; i < fg->nb_outputs; i++) {
@@ -551,6 +551,123 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+/* choose the quantizers and the coding tools of a channel element */
+static void search_element(AVCodecContext *avctx, AACEncContext *s,
+                           AACEncElement *el, int tag, ChannelElement *cpe,
+                           FFPsyWindowInfo *wi)
+{
+    SingleChannelElement *sce;
+    int ch, w;
+    int chans    = tag == TYPE_CPE ? 2 : 1;
+    int start_ch = el->start_ch;
+
+    s->cur_type = tag;
+    for (ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        if (s->options.pns && s->coder->mark_pns)
+            s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+        s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+    }
+    if (chans > 1
+        && wi[0].window_type[0] == wi[1].window_type[0]
+        && wi[0].window_shape   == wi[1].window_shape) {
+
+        cpe->common_window = 1;
+        for (w = 0; w < wi[0].num_windows; w++) {
+            if (wi[0].grouping[w] != wi[1].grouping[w]) {
+                cpe->common_window = 0;
+                break;
+            }
+        }
+    }
+    for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
+        sce = &cpe->ch[ch];
+        s->cur_channel = start_ch + ch;
+        if (s->options.tns && s->coder->search_for_tns)
+            s->coder->search_for_tns(s, sce);
+        if (s->options.tns && s->coder->apply_tns_filt)
+            s->coder->apply_tns_filt(s, sce);
+        if (sce->tns.present)
+            el->tns_mode = 1;
+        if (s->options.pns && s->coder->search_for_pns)
+            s->coder->search_for_pns(s, avctx, sce);
+    }
+    s->cur_channel = start_ch;
+    if (s->options.intensity_stereo) { /* Intensity Stereo */
+        if (s->coder->search_for_is)
+            s->coder->search_for_is(s, avctx, cpe);
+        if (cpe->is_mode) el->is_mode = 1;
+        apply_intensity_stereo(cpe);
+    }
+    if (s->options.pred) { /* Prediction */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->search_for_pred)
+                s->coder->search_for_pred(s, sce);
+            if (cpe->ch[ch].ics.predictor_present) el->pred_mode = 1;
+        }
+        if (s->coder->adjust_common_pred)
+            s->coder->adjust_common_pred(s, cpe);
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->apply_main_pred)
+                s->coder->apply_main_pred(s, sce);
+        }
+        s->cur_channel = start_ch;
+    }
+    if (s->options.mid_side) { /* Mid/Side stereo */
+        if (s->options.mid_side == -1 && s->coder->search_for_ms)
+            s->coder->search_for_ms(s, cpe);
+        else if (cpe->common_window)
+            memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
+        apply_mid_side_stereo(cpe);
+    }
+    adjust_frame_information(cpe, chans);
+    if (s->options.ltp) { /* LTP */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->coder->search_for_ltp)
+                s->coder->search_for_ltp(s, sce, cpe->common_window);
+            if (sce->ics.ltp.present) el->pred_mode = 1;
+        }
+        s->cur_channel = start_ch;
+        if (s->coder->adjust_common_ltp)
+            s->coder->adjust_common_ltp(s, cpe);
+    }
+}
+
+/*
+ * Channel elements only depend on each other through the psy model, which
+ * has run before, so they are searched in parallel. Each slice thread has its
+ * own context for the scratch buffers of the coder, and each element its own
+ * PNS noise generator, so that the output does not depend on the threads.
+ */
+static int search_element_thread(AVCodecContext *avctx, void *arg,
+                                 int jobnr, int threadnr)
+{
+    AACEncContext *s     = avctx->priv_data;
+    AACEncContext *ts    = threadnr ? s->slice_ctx[threadnr - 1] : s;
+    AACEncElement *el;
+    FFPsyWindowInfo *wi;
+
+    jobnr += s->search_start;
+    el     = &s->elements[jobnr];
+    wi     = (FFPsyWindowInfo *)arg + el->start_ch;
+
+    ts->lambda           = s->lambda;
+    ts->psy.bitres.alloc = el->bitres_alloc;
+    ts->psy.cutoff       = el->cutoff;
+    ts->random_state     = el->random_state;
+    search_element(avctx, ts, el, s->chan_map[jobnr + 1], &s->cpe[jobnr], wi);
+    el->cutoff           = ts->psy.cutoff;
+    el->random_state     = ts->random_state;
+
+    return 0;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -687,6 +804,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         start_ch = 0;
         target_bits = 0;
         memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        s->search_start = 0;
         for (i = 0; i < s->chan_map[0]; i++) {
             FFPsyWindowInfo* wi = windows + start_ch;
             const float *coeffs[2];
@@ -696,8 +814,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -719,82 +835,41 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
-            s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
-            if (chans > 1
-                && wi[0].window_type[0] == wi[1].window_type[0]
-                && wi[0].window_shape   == wi[1].window_shape) {
-
-                cpe->common_window = 1;
-                for (w = 0; w < wi[0].num_windows; w++) {
-                    if (wi[0].grouping[w] != wi[1].grouping[w]) {
-                        cpe->common_window = 0;
-                        break;
-                    }
-                }
-            }
-            for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
-                sce = &cpe->ch[ch];
-                s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
-                    s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
-                    s->coder->apply_tns_filt(s, sce);
-                if (sce->tns.present)
-                    tns_mode = 1;
-                if (s->options.pns && s->coder->search_for_pns)
-                    s->coder->search_for_pns(s, avctx, sce);
-            }
-            s->cur_channel = start_ch;
-            if (s->options.intensity_stereo) { /* Intensity Stereo */
-                if (s->coder->search_for_is)
-                    s->coder->search_for_is(s, avctx, cpe);
-                if (cpe->is_mode) is_mode = 1;
-                apply_intensity_stereo(cpe);
-            }
-            if (s->options.pred) { /* Prediction */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->search_for_pred)
-                        s->coder->search_for_pred(s, sce);
-                    if (cpe->ch[ch].ics.predictor_present) pred_mode = 1;
-                }
-                if (s->coder->adjust_common_pred)
-                    s->coder->adjust_common_pred(s, cpe);
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->apply_main_pred)
-                        s->coder->apply_main_pred(s, sce);
-                }
-                s->cur_channel = start_ch;
-            }
-            if (s->options.mid_side) { /* Mid/Side stereo */
-                if (s->options.mid_side == -1 && s->coder->search_for_ms)
-                    s->coder->search_for_ms(s, cpe);
-                else if (cpe->common_window)
-                    memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
-                apply_mid_side_stereo(cpe);
-            }
-            adjust_frame_information(cpe, chans);
-            if (s->options.ltp) { /* LTP */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->coder->search_for_ltp)
-                        s->coder->search_for_ltp(s, sce, cpe->common_window);
-                    if (sce->ics.ltp.present) pred_mode = 1;
-                }
-                s->cur_channel = start_ch;
-                if (s->coder->adjust_common_ltp)
-                    s->coder->adjust_common_ltp(s, cpe);
+            s->elements[i].start_ch     = start_ch;
+            s->elements[i].bitres_alloc = s->psy.bitres.alloc;
+            s->elements[i].cutoff       = s->psy.cutoff;
+            s->elements[i].is_mode      = 0;
+            s->elements[i].tns_mode     = 0;
+            s->elements[i].pred_mode    = 0;
+            start_ch += chans;
+
+            /* The psy analysis of all the elements runs before their searches,
+             * but the first search of the twoloop coder sets the psy cutoff
+             * used by the analysis of the following elements. It does not
+             * change afterwards, so only search the first element on its own
+             * the first time. */
+            if (!i && s->chan_map[0] > 1 && avctx->frame_number == 1 && !its) {
+                search_element_thread(avctx, windows, 0, 0);
+                s->psy.cutoff   = s->elements[0].cutoff;
+                s->search_start = 1;
             }
+        }
+
+        avctx->execute2(avctx, search_element_thread, windows, NULL,
+                        s->chan_map[0] - s->search_start);
+
+        start_ch = 0;
+        for (i = 0; i < s->chan_map[0]; i++) {
+            /* the twoloop coder sets the psy cutoff from the bitrate */
+            s->psy.cutoff = s->elements[i].cutoff;
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
+            is_mode   |= s->elements[i].is_mode;
+            tns_mode  |= s->elements[i].tns_mode;
+            pred_mode |= s->elements[i].pred_mode;
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             if (chans == 2) {
                 put_bits(&s->pb, 1, cpe->common_window);
                 if (cpe->common_window) {
@@ -897,6 +972,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 static av_cold int aac_encode_end(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
+    int i;
 
     av_log(avctx, AV_LOG_INFO, "Qavg: %.3f\n", s->lambda_count ? s->lambda_sum / s->lambda_count : NAN);
 
@@ -904,6 +980,12 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     ff_mdct_end(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    for (i = 0; i < s->nb_slice_ctx; i++) {
+        if (s->slice_ctx[i])
+            ff_lpc_end(&s->slice_ctx[i]->lpc);
+        av_freep(&s->slice_ctx[i]);
+    }
+    av_freep(&s->slice_ctx);
     if (s->psypp)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
@@ -1086,6 +1168,8 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
     s->psypp = ff_psy_preprocess_init(avctx);
     ff_lpc_init(&s->lpc, 2*avctx->frame_size, TNS_MAX_ORDER, FF_LPC_TYPE_LEVINSON);
     s->random_state = 0x1f2e3d4c;
+    for (i = 0; i < s->chan_map[0]; i++)
+        s->elements[i].random_state = s->random_state;
 
     s->abs_pow34   = abs_pow34_v;
     s->quant_bands = quantize_bands;
@@ -1099,6 +1183,26 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
     ff_af_queue_init(avctx, &s->afq);
     ff_aac_tableinit();
 
+    /* the other slice threads get a copy of the context with their own
+     * scratch buffers */
+    if (avctx->active_thread_type & FF_THREAD_SLICE && s->chan_map[0] > 1) {
+        int nb_slice_ctx = avctx->thread_count - 1;
+        if (!FF_ALLOCZ_TYPED_ARRAY(s->slice_ctx, nb_slice_ctx))
+            return AVERROR(ENOMEM);
+        s->nb_slice_ctx = nb_slice_ctx;
+        for (i = 0; i < nb_slice_ctx; i++) {
+            AACEncContext *ts = av_memdup(s, sizeof(*s));
+            if (!ts)
+                return AVERROR(ENOMEM);
+            s->slice_ctx[i] = ts;
+            ts->slice_ctx    = NULL;
+            ts->nb_slice_ctx = 0;
+            if ((ret = ff_lpc_init(&ts->lpc, 2*avctx->frame_size, TNS_MAX_ORDER,
+                                   FF_LPC_TYPE_LEVINSON)) < 0)
+                return ret;
+        }
+    }
+
     return 0;
 }
 
@@ -1143,7 +1247,8 @@ AVCodec ff_aac_encoder = {
     .defaults       = aac_encode_defaults,
     .supported_samplerates = mpeg4audio_sample_rates,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                      AV_SAMPLE_FMT_NONE },
     .priv_class     = &aacenc_class,
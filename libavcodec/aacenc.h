@@ -372,6 +372,18 @@ static const AACPCEInfo aac_pce_configs[] = {
     },
 };
 
+/**
+ * State of a channel element, carried between the coding of its channels
+ * in the threads and the writing of the bitstream
+ */
+typedef struct AACEncElement {
+    int start_ch;                                ///< first channel of the element
+    int bitres_alloc;                            ///< bits allocated by the psy model
+    int random_state;                            ///< PNS noise generator state
+    int cutoff;                                  ///< psy cutoff, may be set by the coder
+    int is_mode, tns_mode, pred_mode;            ///< tools used in this frame
+} AACEncElement;
+
 /**
  * AAC encoder context
  */
@@ -420,6 +432,11 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    AACEncElement elements[16];                  ///< state of the channel elements
+    int search_start;                            ///< first element searched by the slice jobs
+    struct AACEncContext **slice_ctx;            ///< contexts of the other slice threads
+    int nb_slice_ctx;
 } AACEncContext;
 
 void ff_aac_dsp_init_x86(AACEncContext *s);
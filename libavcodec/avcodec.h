@@ -2382,6 +2382,29 @@ typedef struct AVCodecContext {
      * - decoding: unused
      */
     int (*get_encode_buffer)(struct AVCodecContext *s, AVPacket *pkt, int flags);
+
+    /**
+     * Number of slice threads run by each frame thread, for decoders which
+     * can combine frame and slice threading. When larger than 1 and
+     * thread_type contains both FF_THREAD_FRAME and FF_THREAD_SLICE,
+     * thread_count threads are split into thread_count / frame_slice_threads
+     * frame threads, which lowers the delay compared to frame threading
+     * alone.
+     * - encoding: unused
+     * - decoding: Set by user.
+     */
+    int frame_slice_threads;
+
+    /**
+     * Maximum number of frames in flight with frame threading. When set,
+     * decoded frames are returned as soon as the oldest one is finished
+     * instead of only after thread_count packets were sent, so the delay
+     * follows the actual decoding speed up to this limit (clipped to
+     * thread_count).
+     * - encoding: unused
+     * - decoding: Set by user. 0 (default) disables it.
+     */
+    int frame_thread_max_delay;
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
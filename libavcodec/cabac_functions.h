@@ -175,6 +175,38 @@ static av_always_inline int get_cabac_bypass_sign(CABACContext *c, int val){
 }
 #endif
 
+#ifndef get_cabac_bypass_bits
+/**
+ * Decode n bypass bins, the first one ending up in the most significant bit.
+ * Decoding bypass bins is a binary long division of the offset by the range,
+ * so all the bins before the next refill are decoded with a single division
+ * instead of one compare and branch per bin.
+ */
+static av_always_inline unsigned get_cabac_bypass_bits(CABACContext *c, int n)
+{
+    unsigned bits = 0;
+
+    while (n > 0) {
+        unsigned range = c->range << (CABAC_BITS + 1);
+        int k = FFMIN(n, CABAC_BITS - 1 - ff_ctz(c->low & CABAC_MASK));
+
+        if (k < 2 || (unsigned)c->low >= range) {
+            bits = (bits << 1) | get_cabac_bypass(c);
+            n--;
+        } else {
+            uint64_t low = (uint64_t)c->low << k;
+            unsigned q   = low / range;
+
+            c->low = low - (uint64_t)q * range;
+            bits   = (bits << k) | q;
+            n     -= k;
+        }
+    }
+
+    return bits;
+}
+#endif
+
 /**
  * @return the number of bytes read or 0 if no end
  */
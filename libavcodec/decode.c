@@ -302,6 +302,7 @@ static inline int decode_simple_internal(AVCodecContext *avctx, AVFrame *frame,
     DecodeSimpleContext *ds = &avci->ds;
     AVPacket           *pkt = ds->in_pkt;
     int got_frame, actual_got_frame;
+    int pkt_kept = 0;
     int ret;
 
     if (!pkt->data && !avci->draining) {
@@ -325,6 +326,8 @@ static inline int decode_simple_internal(AVCodecContext *avctx, AVFrame *frame,
 
     if (HAVE_THREADS && avctx->active_thread_type & FF_THREAD_FRAME) {
         ret = ff_thread_decode_frame(avctx, frame, &got_frame, pkt);
+        /* in low delay mode a frame can be returned before the packet is used */
+        pkt_kept = !ret && pkt->size;
     } else {
         ret = avctx->codec->decode(avctx, frame, &got_frame, pkt);
 
@@ -464,7 +467,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (!got_frame)
         av_frame_unref(frame);
 
-    if (ret >= 0 && avctx->codec->type == AVMEDIA_TYPE_VIDEO && !(avctx->flags & AV_CODEC_FLAG_TRUNCATED))
+    if (ret >= 0 && avctx->codec->type == AVMEDIA_TYPE_VIDEO && !(avctx->flags & AV_CODEC_FLAG_TRUNCATED) &&
+        !pkt_kept)
         ret = pkt->size;
 
 #if FF_API_AVCTX_TIMEBASE
@@ -499,7 +503,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (ret >= pkt->size || ret < 0) {
         av_packet_unref(pkt);
         av_packet_unref(avci->last_pkt_props);
-    } else {
+    } else if (!pkt_kept) {
         int consumed = ret;
 
         pkt->data                += consumed;
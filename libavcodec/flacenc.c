@@ -93,6 +93,7 @@ typedef struct FlacSubframe {
 
 typedef struct FlacFrame {
     FlacSubframe subframes[FLAC_MAX_CHANNELS];
+    int subframe_bits[FLAC_MAX_CHANNELS];
     int blocksize;
     int bs_code[2];
     uint8_t crc8;
@@ -114,7 +115,14 @@ typedef struct FlacEncodeContext {
     uint32_t frame_count;
     uint64_t sample_count;
     uint8_t md5sum[16];
-    FlacFrame frame;
+    FlacFrame *frame;               ///< frame being coded
+    FlacFrame *frames;              ///< frames whose subframes are searched together
+    int nb_frames;
+    AVFrame **queued_frames;        ///< input frames waiting to be coded
+    int nb_queued_frames;
+    AVPacket **pkts;                ///< coded frames waiting to be returned
+    int nb_pkts, next_pkt;
+    struct FlacEncodeContext **thread_ctx; ///< per slice thread copies of the context
     CompressionOptions options;
     AVCodecContext *avctx;
     LPCContext lpc_ctx;
@@ -241,7 +249,7 @@ static av_cold int flac_encode_init(AVCodecContext *avctx)
     int freq = avctx->sample_rate;
     int channels = avctx->channels;
     FlacEncodeContext *s = avctx->priv_data;
-    int i, level, ret;
+    int i, level, nb_threads, ret;
     uint8_t *streaminfo;
 
     s->avctx = avctx;
@@ -461,9 +469,45 @@ FF_ENABLE_DEPRECATION_WARNINGS
     ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt, channels,
                     avctx->bits_per_raw_sample);
 
+    if (ret < 0)
+        return ret;
+
+    /* code several frames at once so that all slice threads get a subframe */
+    s->nb_frames = 1;
+    if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1)
+        s->nb_frames = (2 * avctx->thread_count + channels - 1) / channels;
+    nb_threads = FFMAX(avctx->thread_count, 1);
+
+    s->frames        = av_calloc(s->nb_frames, sizeof(*s->frames));
+    s->queued_frames = av_calloc(s->nb_frames, sizeof(*s->queued_frames));
+    s->pkts          = av_calloc(s->nb_frames, sizeof(*s->pkts));
+    s->thread_ctx    = av_calloc(nb_threads + 1, sizeof(*s->thread_ctx));
+    if (!s->frames || !s->queued_frames || !s->pkts || !s->thread_ctx)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_frames; i++) {
+        s->queued_frames[i] = av_frame_alloc();
+        s->pkts[i]          = av_packet_alloc();
+        if (!s->queued_frames[i] || !s->pkts[i])
+            return AVERROR(ENOMEM);
+    }
+    s->frame = &s->frames[0];
+
+    s->thread_ctx[0] = s;
+    for (i = 1; i < nb_threads; i++) {
+        FlacEncodeContext *ts = av_memdup(s, sizeof(*s));
+        if (!ts)
+            return AVERROR(ENOMEM);
+        memset(&ts->lpc_ctx, 0, sizeof(ts->lpc_ctx));
+        s->thread_ctx[i] = ts;
+        ret = ff_lpc_init(&ts->lpc_ctx, avctx->frame_size,
+                          s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+        if (ret < 0)
+            return ret;
+    }
+
     dprint_compression_options(s);
 
-    return ret;
+    return 0;
 }
 
 
@@ -472,7 +516,7 @@ static void init_frame(FlacEncodeContext *s, int nb_samples)
     int i, ch;
     FlacFrame *frame;
 
-    frame = &s->frame;
+    frame = s->frame;
 
     for (i = 0; i < 16; i++) {
         if (nb_samples == ff_flac_blocksize_table[i]) {
@@ -521,7 +565,7 @@ static void copy_samples(FlacEncodeContext *s, const void *samples)
 
 #define COPY_SAMPLES(bits) do {                                     \
     const int ## bits ## _t *samples0 = samples;                    \
-    frame = &s->frame;                                              \
+    frame = s->frame;                                               \
     for (i = 0, j = 0; i < frame->blocksize; i++)                   \
         for (ch = 0; ch < s->channels; ch++, j++)                   \
             frame->subframes[ch].samples[i] = samples0[j] >> shift; \
@@ -565,7 +609,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
     if (sub->type == FLAC_SUBFRAME_CONSTANT) {
         count += sub->obits;
     } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
-        count += s->frame.blocksize * sub->obits;
+        count += s->frame->blocksize * sub->obits;
     } else {
         /* warm-up samples */
         count += pred_order * sub->obits;
@@ -579,7 +623,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
 
         /* partition order */
         porder = sub->rc.porder;
-        psize  = s->frame.blocksize >> porder;
+        psize  = s->frame->blocksize >> porder;
         count += 4;
 
         /* residual */
@@ -590,7 +634,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
             count += sub->rc.coding_mode;
             count += rice_count_exact(&sub->residual[i], part_end - i, k);
             i = part_end;
-            part_end = FFMIN(s->frame.blocksize, part_end + psize);
+            part_end = FFMIN(s->frame->blocksize, part_end + psize);
         }
     }
 
@@ -755,15 +799,15 @@ static uint64_t find_subframe_rice_params(FlacEncodeContext *s,
                                           FlacSubframe *sub, int pred_order)
 {
     int pmin = get_max_p_order(s->options.min_partition_order,
-                               s->frame.blocksize, pred_order);
+                               s->frame->blocksize, pred_order);
     int pmax = get_max_p_order(s->options.max_partition_order,
-                               s->frame.blocksize, pred_order);
+                               s->frame->blocksize, pred_order);
 
     uint64_t bits = 8 + pred_order * sub->obits + 2 + sub->rc.coding_mode;
     if (sub->type == FLAC_SUBFRAME_LPC)
         bits += 4 + 5 + pred_order * s->options.lpc_coeff_precision;
     bits += calc_rice_params(&sub->rc, sub->rc_udata, sub->rc_sums, pmin, pmax, sub->residual,
-                             s->frame.blocksize, pred_order, s->options.exact_rice_parameters);
+                             s->frame->blocksize, pred_order, s->options.exact_rice_parameters);
     return bits;
 }
 
@@ -829,7 +873,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
     int shift[MAX_LPC_ORDER];
     int32_t *res, *smp;
 
-    frame = &s->frame;
+    frame = s->frame;
     sub   = &frame->subframes[ch];
     res   = sub->residual;
     smp   = sub->samples;
@@ -1039,9 +1083,9 @@ static int count_frame_header(FlacEncodeContext *s)
     PUT_UTF8(s->frame_count, tmp, count += 8;)
 
     /* explicit block size */
-    if (s->frame.bs_code[0] == 6)
+    if (s->frame->bs_code[0] == 6)
         count += 8;
-    else if (s->frame.bs_code[0] == 7)
+    else if (s->frame->bs_code[0] == 7)
         count += 16;
 
     /* explicit sample rate */
@@ -1054,7 +1098,7 @@ static int count_frame_header(FlacEncodeContext *s)
 }
 
 
-static int encode_frame(FlacEncodeContext *s)
+static int count_frame(FlacEncodeContext *s)
 {
     int ch;
     uint64_t count;
@@ -1062,7 +1106,7 @@ static int encode_frame(FlacEncodeContext *s)
     count = count_frame_header(s);
 
     for (ch = 0; ch < s->channels; ch++)
-        count += encode_residual_ch(s, ch);
+        count += s->frame->subframe_bits[ch];
 
     count += (8 - (count & 7)) & 7; // byte alignment
     count += 16;                    // CRC-16
@@ -1074,15 +1118,45 @@ static int encode_frame(FlacEncodeContext *s)
 }
 
 
+static int encode_frame(FlacEncodeContext *s)
+{
+    int ch;
+
+    for (ch = 0; ch < s->channels; ch++)
+        s->frame->subframe_bits[ch] = encode_residual_ch(s, ch);
+
+    return count_frame(s);
+}
+
+
+/**
+ * Search the coding of one subframe of the queued frames. The subframes of
+ * different frames and channels are independent, so they are searched in
+ * parallel, each slice thread using its own LPC context.
+ */
+static int encode_residual_thread(AVCodecContext *avctx, void *arg,
+                                  int jobnr, int threadnr)
+{
+    FlacEncodeContext *s  = avctx->priv_data;
+    FlacEncodeContext *ts = s->thread_ctx[threadnr];
+    int ch = jobnr % s->channels;
+
+    ts->frame = &s->frames[jobnr / s->channels];
+    ts->frame->subframe_bits[ch] = encode_residual_ch(ts, ch);
+
+    return 0;
+}
+
+
 static void remove_wasted_bits(FlacEncodeContext *s)
 {
     int ch, i;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &s->frame->subframes[ch];
         int32_t v         = 0;
 
-        for (i = 0; i < s->frame.blocksize; i++) {
+        for (i = 0; i < s->frame->blocksize; i++) {
             v |= sub->samples[i];
             if (v & 1)
                 break;
@@ -1091,7 +1165,7 @@ static void remove_wasted_bits(FlacEncodeContext *s)
         if (v && !(v & 1)) {
             v = ff_ctz(v);
 
-            for (i = 0; i < s->frame.blocksize; i++)
+            for (i = 0; i < s->frame->blocksize; i++)
                 sub->samples[i] >>= v;
 
             sub->wasted = v;
@@ -1156,7 +1230,7 @@ static void channel_decorrelation(FlacEncodeContext *s)
     int32_t *left, *right;
     int i, n;
 
-    frame = &s->frame;
+    frame = s->frame;
     n     = frame->blocksize;
     left  = frame->subframes[0].samples;
     right = frame->subframes[1].samples;
@@ -1207,7 +1281,7 @@ static void write_frame_header(FlacEncodeContext *s)
     FlacFrame *frame;
     int crc;
 
-    frame = &s->frame;
+    frame = s->frame;
 
     put_bits(&s->pb, 16, 0xFFF8);
     put_bits(&s->pb, 4, frame->bs_code[0]);
@@ -1244,11 +1318,11 @@ static void write_subframes(FlacEncodeContext *s)
     int ch;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &s->frame->subframes[ch];
         int i, p, porder, psize;
         int32_t *part_end;
         int32_t *res       =  sub->residual;
-        int32_t *frame_end = &sub->residual[s->frame.blocksize];
+        int32_t *frame_end = &sub->residual[s->frame->blocksize];
 
         /* subframe header */
         put_bits(&s->pb, 1, 0);
@@ -1282,7 +1356,7 @@ static void write_subframes(FlacEncodeContext *s)
 
             /* partition order */
             porder  = sub->rc.porder;
-            psize   = s->frame.blocksize >> porder;
+            psize   = s->frame->blocksize >> porder;
             put_bits(&s->pb, 4, porder);
 
             /* residual */
@@ -1323,7 +1397,7 @@ static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
 static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = s->frame->blocksize * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1344,7 +1418,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < s->frame->blocksize * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1356,14 +1430,115 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+/* code the queued frames into packets */
+static int encode_queued_frames(AVCodecContext *avctx)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int i, frame_bytes, out_bytes, ret;
+
+    for (i = 0; i < s->nb_queued_frames; i++) {
+        const AVFrame *frame = s->queued_frames[i];
+
+        s->frame = &s->frames[i];
+
+        init_frame(s, frame->nb_samples);
+
+        copy_samples(s, frame->data[0]);
+
+        channel_decorrelation(s);
+
+        remove_wasted_bits(s);
+    }
+
+    avctx->execute2(avctx, encode_residual_thread, NULL, NULL,
+                    s->nb_queued_frames * s->channels);
+
+    for (i = 0; i < s->nb_queued_frames; i++) {
+        const AVFrame *frame = s->queued_frames[i];
+        AVPacket *avpkt      = s->pkts[i];
+
+        /* change max_framesize for small final frame */
+        if (s->frame_count && frame->nb_samples < avctx->frame_size) {
+            s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                          s->channels,
+                                                          avctx->bits_per_raw_sample);
+        }
+
+        s->frame = &s->frames[i];
+
+        frame_bytes = count_frame(s);
+
+        /* Fall back on verbatim mode if the compressed frame is larger than it
+           would be if encoded uncompressed. */
+        if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
+            s->frame->verbatim_only = 1;
+            frame_bytes = encode_frame(s);
+            if (frame_bytes < 0) {
+                av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
+                return frame_bytes;
+            }
+        }
+
+        if ((ret = av_new_packet(avpkt, frame_bytes)) < 0)
+            return ret;
+
+        out_bytes = write_frame(s, avpkt);
+
+        s->frame_count++;
+        s->sample_count += frame->nb_samples;
+        if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+            return ret;
+        }
+        if (out_bytes > s->max_encoded_framesize)
+            s->max_encoded_framesize = out_bytes;
+        if (out_bytes < s->min_framesize)
+            s->min_framesize = out_bytes;
+
+        avpkt->pts      = frame->pts;
+        avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
+        avpkt->size     = out_bytes;
+
+        s->next_pts = avpkt->pts + avpkt->duration;
+
+        av_frame_unref(s->queued_frames[i]);
+    }
+
+    s->nb_pkts          = s->nb_queued_frames;
+    s->next_pkt         = 0;
+    s->nb_queued_frames = 0;
+    return 0;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
     FlacEncodeContext *s;
-    int frame_bytes, out_bytes, ret;
+    int ret;
 
     s = avctx->priv_data;
 
+    /* with slice threads, frames are queued until nb_frames of them can be
+     * coded together */
+    if (frame) {
+        if ((ret = av_frame_ref(s->queued_frames[s->nb_queued_frames], frame)) < 0)
+            return ret;
+        s->nb_queued_frames++;
+    }
+
+    if (s->next_pkt == s->nb_pkts && s->nb_queued_frames &&
+        (!frame || s->nb_queued_frames == s->nb_frames)) {
+        if ((ret = encode_queued_frames(avctx)) < 0)
+            return ret;
+    }
+
+    if (s->next_pkt < s->nb_pkts) {
+        av_packet_move_ref(avpkt, s->pkts[s->next_pkt++]);
+        *got_packet_ptr = 1;
+        return 0;
+    }
+
     /* when the last block is reached, update the header in extradata */
     if (!frame) {
         s->max_framesize = s->max_encoded_framesize;
@@ -1388,61 +1563,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
             *got_packet_ptr = 1;
             s->flushed = 1;
         }
-
-        return 0;
-    }
-
-    /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
-        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
-                                                      s->channels,
-                                                      avctx->bits_per_raw_sample);
-    }
-
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
-
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
     }
 
-    if ((ret = ff_alloc_packet2(avctx, avpkt, frame_bytes, 0)) < 0)
-        return ret;
-
-    out_bytes = write_frame(s, avpkt);
-
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
-        return ret;
-    }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
-
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
-    avpkt->size     = out_bytes;
-
-    s->next_pts = avpkt->pts + avpkt->duration;
-
-    *got_packet_ptr = 1;
     return 0;
 }
 
@@ -1451,9 +1573,27 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
 {
     if (avctx->priv_data) {
         FlacEncodeContext *s = avctx->priv_data;
+        int i;
+
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
         ff_lpc_end(&s->lpc_ctx);
+        for (i = 0; s->thread_ctx && s->thread_ctx[i]; i++) {
+            if (s->thread_ctx[i] != s) {
+                ff_lpc_end(&s->thread_ctx[i]->lpc_ctx);
+                av_free(s->thread_ctx[i]);
+            }
+        }
+        av_freep(&s->thread_ctx);
+        for (i = 0; i < s->nb_frames; i++) {
+            if (s->queued_frames)
+                av_frame_free(&s->queued_frames[i]);
+            if (s->pkts)
+                av_packet_free(&s->pkts[i]);
+        }
+        av_freep(&s->queued_frames);
+        av_freep(&s->pkts);
+        av_freep(&s->frames);
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1508,7 +1648,8 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
@@ -31,17 +31,26 @@
 #include "thread.h"
 
 #define MAX_THREADS 64
-/* There can be as many as MAX_THREADS + 1 outstanding tasks.
- * An additional + 1 is needed so that one can distinguish
- * the case of zero and MAX_THREADS + 1 outstanding tasks modulo
- * the number of buffers. */
-#define BUFFER_SIZE (MAX_THREADS + 2)
+/* Up to one task per thread can be queued in addition to the ones being
+ * encoded, so that the workers do not run out of work while the main thread
+ * waits for a slow task to output the packets in order. There can thus be
+ * as many as 2 * MAX_THREADS outstanding tasks. An additional + 1 is needed
+ * so that one can distinguish the case of zero and 2 * MAX_THREADS + 1
+ * outstanding tasks modulo the number of buffers. */
+#define MAX_PENDING(thread_count) (2 * (thread_count))
+#define BUFFER_SIZE (MAX_PENDING(MAX_THREADS) + 2)
 
 typedef struct{
     AVFrame  *indata;
     AVPacket *outdata;
     int       return_code;
     int       finished;
+
+    /* Pool for the packets that are not already reference counted.
+     * It is reinitialized with a larger size whenever a packet does
+     * not fit. */
+    AVBufferPool *pkt_pool;
+    int           pkt_pool_size;
 } Task;
 
 typedef struct{
@@ -64,6 +73,34 @@ typedef struct{
     atomic_int exit;
 } ThreadContext;
 
+static int packet_make_refcounted(Task *task, AVPacket *pkt)
+{
+    int size = pkt->size + AV_INPUT_BUFFER_PADDING_SIZE;
+    AVBufferRef *buf;
+
+    if (pkt->buf)
+        return 0;
+
+    if (size > task->pkt_pool_size) {
+        av_buffer_pool_uninit(&task->pkt_pool);
+        task->pkt_pool_size = FFMAX(size, task->pkt_pool_size / 4 * 5);
+        task->pkt_pool      = av_buffer_pool_init(task->pkt_pool_size, NULL);
+        if (!task->pkt_pool) {
+            task->pkt_pool_size = 0;
+            return AVERROR(ENOMEM);
+        }
+    }
+    if (!(buf = av_buffer_pool_get(task->pkt_pool)))
+        return AVERROR(ENOMEM);
+
+    memcpy(buf->data, pkt->data, pkt->size);
+    memset(buf->data + pkt->size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    pkt->buf  = buf;
+    pkt->data = buf->data;
+
+    return 0;
+}
+
 static void * attribute_align_arg worker(void *v){
     AVCodecContext *avctx = v;
     ThreadContext *c = avctx->internal->frame_thread_encoder;
@@ -96,7 +133,7 @@ static void * attribute_align_arg worker(void *v){
 
         ret = avctx->codec->encode2(avctx, pkt, frame, &got_packet);
         if(got_packet) {
-            int ret2 = av_packet_make_refcounted(pkt);
+            int ret2 = packet_make_refcounted(task, pkt);
             if (ret >= 0 && ret2 < 0)
                 ret = ret2;
             pkt->pts = pkt->dts = frame->pts;
@@ -194,7 +231,7 @@ int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
     pthread_cond_init(&c->finished_task_cond, NULL);
     atomic_init(&c->exit, 0);
 
-    c->max_tasks = avctx->thread_count + 2;
+    c->max_tasks = MAX_PENDING(avctx->thread_count) + 2;
     for (unsigned i = 0; i < c->max_tasks; i++) {
         if (!(c->tasks[i].indata  = av_frame_alloc()) ||
             !(c->tasks[i].outdata = av_packet_alloc()))
@@ -268,6 +305,7 @@ void ff_frame_thread_encoder_free(AVCodecContext *avctx){
     for (unsigned i = 0; i < c->max_tasks; i++) {
         av_frame_free(&c->tasks[i].indata);
         av_packet_free(&c->tasks[i].outdata);
+        av_buffer_pool_uninit(&c->tasks[i].pkt_pool);
     }
 
     pthread_mutex_destroy(&c->task_fifo_mutex);
@@ -301,7 +339,7 @@ int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
      * because it is only ever changed by the main thread. */
     if (c->task_index == c->finished_task_index ||
         (frame && !outtask->finished &&
-         (c->task_index - c->finished_task_index + c->max_tasks) % c->max_tasks <= avctx->thread_count)) {
+         (c->task_index - c->finished_task_index + c->max_tasks) % c->max_tasks <= MAX_PENDING(avctx->thread_count))) {
             pthread_mutex_unlock(&c->finished_task_mutex);
             return 0;
         }
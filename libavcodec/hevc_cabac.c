@@ -993,14 +993,12 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCContext *s, int
     int prefix = 0;
     int suffix = 0;
     int last_coeff_abs_level_remaining;
-    int i;
 
     while (prefix < CABAC_MAX_BIN && get_cabac_bypass(&s->HEVClc->cc))
         prefix++;
 
     if (prefix < 3) {
-        for (i = 0; i < rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&s->HEVClc->cc);
+        suffix = get_cabac_bypass_bits(&s->HEVClc->cc, rc_rice_param);
         last_coeff_abs_level_remaining = (prefix << rc_rice_param) + suffix;
     } else {
         int prefix_minus3 = prefix - 3;
@@ -1010,8 +1008,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCContext *s, int
             return 0;
         }
 
-        for (i = 0; i < prefix_minus3 + rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&s->HEVClc->cc);
+        suffix = get_cabac_bypass_bits(&s->HEVClc->cc, prefix_minus3 + rc_rice_param);
         last_coeff_abs_level_remaining = (((1 << prefix_minus3) + 3 - 1)
                                               << rc_rice_param) + suffix;
     }
@@ -1020,12 +1017,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCContext *s, int
 
 static av_always_inline int coeff_sign_flag_decode(HEVCContext *s, uint8_t nb)
 {
-    int i;
-    int ret = 0;
-
-    for (i = 0; i < nb; i++)
-        ret = (ret << 1) | get_cabac_bypass(&s->HEVClc->cc);
-    return ret;
+    return get_cabac_bypass_bits(&s->HEVClc->cc, nb);
 }
 
 void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
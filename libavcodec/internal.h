@@ -83,6 +83,11 @@
  * internal logic derive them from AVCodecInternal.last_pkt_props.
  */
 #define FF_CODEC_CAP_SETS_FRAME_PROPS       (1 << 8)
+/**
+ * Codec supports slice threading inside each frame thread, see
+ * AVCodecContext.frame_slice_threads.
+ */
+#define FF_CODEC_CAP_FRAME_SLICE_THREADS    (1 << 9)
 
 /**
  * AVCodec.codec_tags termination value
@@ -148,6 +153,7 @@ typedef struct AVCodecInternal {
     AVBufferRef *pool;
 
     void *thread_ctx;
+    void *slice_thread_ctx;
 
     DecodeSimpleContext ds;
     AVBSFContext *bsf;
@@ -19,6 +19,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
+
 #include <dav1d/dav1d.h>
 
 #include "libavutil/avassert.h"
@@ -26,6 +28,7 @@
 #include "libavutil/mastering_display_metadata.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
 
 #include "atsc_a53.h"
 #include "avcodec.h"
@@ -39,8 +42,11 @@
 typedef struct Libdav1dContext {
     AVClass *class;
     Dav1dContext *c;
+    AVCodecContext *avctx;
     AVBufferPool *pool;
     int pool_size;
+    AVMutex get_buffer_mutex;
+    atomic_int user_buffers_unsuitable;
 
     Dav1dData data;
     int tile_threads;
@@ -48,6 +54,7 @@ typedef struct Libdav1dContext {
     int apply_grain;
     int operating_point;
     int all_layers;
+    int user_buffers;
 } Libdav1dContext;
 
 static const enum AVPixelFormat pix_fmt[][3] = {
@@ -68,6 +75,81 @@ static void libdav1d_log_callback(void *opaque, const char *fmt, va_list vl)
     av_vlog(c, AV_LOG_ERROR, fmt, vl);
 }
 
+static void libdav1d_frame_free(void *opaque, uint8_t *data)
+{
+    AVFrame *f = (AVFrame *)data;
+
+    av_frame_free(&f);
+}
+
+/**
+ * Allocate the picture with the user supplied get_buffer2() callback, so that
+ * it is decoded straight into the buffers of the caller (e.g. the frame pool of
+ * a filter graph) instead of being copied there afterwards. Only used when the
+ * caller sets the user_buffers option, as the callback is then called from the
+ * libdav1d threads, concurrently with the calls of the caller.
+ *
+ * @return 0 on success, a negative error code if the callback failed, or 1 if
+ *         the returned buffer does not meet the alignment requirements of
+ *         libdav1d and the internal pool must be used instead
+ */
+static int libdav1d_get_buffer(Libdav1dContext *dav1d, Dav1dPicture *p,
+                               enum AVPixelFormat format, int w, int h)
+{
+    AVCodecContext *c = dav1d->avctx;
+    int planes = p->p.layout == DAV1D_PIXEL_LAYOUT_I400 ? 1 : 3;
+    AVBufferRef *buf;
+    AVFrame *f;
+    int i, ret;
+
+    f = av_frame_alloc();
+    if (!f)
+        return AVERROR(ENOMEM);
+    f->format = format;
+    f->width  = w;
+    f->height = h;
+
+    // libdav1d may allocate pictures from several of its threads at once,
+    // while get_buffer2() must not be called concurrently.
+    ff_mutex_lock(&dav1d->get_buffer_mutex);
+    ret = c->get_buffer2(c, f, AV_GET_BUFFER_FLAG_REF);
+    ff_mutex_unlock(&dav1d->get_buffer_mutex);
+    if (ret < 0) {
+        av_frame_free(&f);
+        return ret;
+    }
+
+    for (i = 0; i < planes; i++) {
+        if (!f->data[i] || f->linesize[i] <= 0 ||
+            ((uintptr_t)f->data[i] | f->linesize[i]) % DAV1D_PICTURE_ALIGNMENT)
+            break;
+    }
+    if (i < planes || (planes > 1 && f->linesize[1] != f->linesize[2])) {
+        // The buffers of a callback are not expected to become suitable later,
+        // so do not allocate and free one for every picture.
+        if (!atomic_exchange(&dav1d->user_buffers_unsuitable, 1))
+            av_log(c, AV_LOG_WARNING, "Buffers returned by get_buffer2() are not "
+                   "suitable for libdav1d, using an internal pool instead.\n");
+        av_frame_free(&f);
+        return 1;
+    }
+
+    buf = av_buffer_create((uint8_t *)f, sizeof(*f), libdav1d_frame_free, dav1d, 0);
+    if (!buf) {
+        av_frame_free(&f);
+        return AVERROR(ENOMEM);
+    }
+
+    p->data[0] = f->data[0];
+    p->data[1] = f->data[1];
+    p->data[2] = f->data[2];
+    p->stride[0] = f->linesize[0];
+    p->stride[1] = f->linesize[1];
+    p->allocator_data = buf;
+
+    return 0;
+}
+
 static int libdav1d_picture_allocator(Dav1dPicture *p, void *cookie)
 {
     Libdav1dContext *dav1d = cookie;
@@ -76,6 +158,12 @@ static int libdav1d_picture_allocator(Dav1dPicture *p, void *cookie)
     uint8_t *aligned_ptr, *data[4];
     AVBufferRef *buf;
 
+    if (dav1d->user_buffers && !atomic_load(&dav1d->user_buffers_unsuitable)) {
+        ret = libdav1d_get_buffer(dav1d, p, format, w, h);
+        if (ret <= 0)
+            return ret;
+    }
+
     ret = av_image_get_buffer_size(format, w, h, DAV1D_PICTURE_ALIGNMENT);
     if (ret < 0)
         return ret;
@@ -137,6 +225,11 @@ static av_cold int libdav1d_init(AVCodecContext *c)
     av_log(c, AV_LOG_INFO, "libdav1d %s\n", dav1d_version());
 
     dav1d_default_settings(&s);
+    dav1d->avctx = c;
+    atomic_init(&dav1d->user_buffers_unsuitable, 0);
+    if (ff_mutex_init(&dav1d->get_buffer_mutex, NULL))
+        return AVERROR(ENOMEM);
+
     s.logger.cookie = c;
     s.logger.callback = libdav1d_log_callback;
     s.allocator.cookie = dav1d;
@@ -172,8 +265,10 @@ static av_cold int libdav1d_init(AVCodecContext *c)
 #endif
 
     res = dav1d_open(&dav1d->c, &s);
-    if (res < 0)
+    if (res < 0) {
+        ff_mutex_destroy(&dav1d->get_buffer_mutex);
         return AVERROR(ENOMEM);
+    }
 
     return 0;
 }
@@ -267,8 +362,24 @@ static int libdav1d_receive_frame(AVCodecContext *c, AVFrame *frame)
     av_assert0(p->data[0] && p->allocator_data);
 
     // This requires the custom allocator above
-    frame->buf[0] = av_buffer_ref(p->allocator_data);
+    if (av_buffer_get_opaque(p->allocator_data) == dav1d) {
+        // The picture was allocated with get_buffer2(), so hand its buffers
+        // over to the caller.
+        const AVFrame *f = (const AVFrame *)((AVBufferRef *)p->allocator_data)->data;
+        int i;
+
+        for (i = 0; i < FF_ARRAY_ELEMS(f->buf) && f->buf[i]; i++) {
+            frame->buf[i] = av_buffer_ref(f->buf[i]);
+            if (!frame->buf[i]) {
+                av_frame_unref(frame);
+                dav1d_picture_unref(p);
+                return AVERROR(ENOMEM);
+            }
+        }
+    } else
+        frame->buf[0] = av_buffer_ref(p->allocator_data);
     if (!frame->buf[0]) {
+        av_frame_unref(frame);
         dav1d_picture_unref(p);
         return AVERROR(ENOMEM);
     }
@@ -471,6 +582,7 @@ static av_cold int libdav1d_close(AVCodecContext *c)
     av_buffer_pool_uninit(&dav1d->pool);
     dav1d_data_unref(&dav1d->data);
     dav1d_close(&dav1d->c);
+    ff_mutex_destroy(&dav1d->get_buffer_mutex);
 
     return 0;
 }
@@ -490,6 +602,7 @@ static const AVOption libdav1d_options[] = {
     { "filmgrain", "Apply Film Grain", OFFSET(apply_grain), AV_OPT_TYPE_BOOL, { .i64 = -1 }, -1, 1, VD | AV_OPT_FLAG_DEPRECATED },
     { "oppoint",  "Select an operating point of the scalable bitstream", OFFSET(operating_point), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 31, VD },
     { "alllayers", "Output all spatial layers", OFFSET(all_layers), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, VD },
+    { "user_buffers", "Decode into the buffers returned by get_buffer2(), called from the libdav1d threads", OFFSET(user_buffers), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, VD },
     { NULL }
 };
 
@@ -49,6 +49,11 @@ typedef struct ICCEntry {
     int    length;
 } ICCEntry;
 
+typedef struct MJpegScanSegment {
+    int start, end;     ///< byte range of a restart interval in buffer
+    int ret;
+} MJpegScanSegment;
+
 typedef struct MJpegDecodeContext {
     AVClass *class;
     AVCodecContext *avctx;
@@ -123,6 +128,13 @@ typedef struct MJpegDecodeContext {
     int restart_interval;
     int restart_count;
 
+    int *rst_offsets;               ///< offsets of the RSTn markers in buffer
+    unsigned int rst_offsets_size;
+    int nb_rst;
+    MJpegScanSegment *segments;     ///< restart intervals decoded by slice threads
+    unsigned int segments_size;
+    int scan_end;                   ///< bit position at the end of a threaded scan
+
     int buggy_avid;
     int cs_itu601;
     int interlace_polarity;
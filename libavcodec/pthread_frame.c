@@ -145,6 +145,10 @@ typedef struct FrameThreadContext {
                                     * Set for the first N packets, where N is the number of threads.
                                     * While it is set, ff_thread_en/decode_frame won't return any results.
                                     */
+
+    int max_delay;                 ///< Maximum number of packets in flight in low delay mode, 0 otherwise.
+    int nb_pending;                ///< Number of submitted packets whose output was not returned yet.
+    int deferred_result;           ///< Error of a frame returned while the packet was kept.
 } FrameThreadContext;
 
 #if FF_API_THREAD_SAFE_CALLBACKS
@@ -502,6 +506,106 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return 0;
 }
 
+/**
+ * Wait for the oldest submitted packet to be decoded and take its output.
+ */
+static int get_oldest_frame(AVCodecContext *avctx, AVFrame *picture,
+                            int *got_picture_ptr)
+{
+    FrameThreadContext *fctx = avctx->internal->thread_ctx;
+    PerThreadContext *p = &fctx->threads[fctx->next_finished];
+    int err;
+
+    if (atomic_load(&p->state) != STATE_INPUT_READY) {
+        pthread_mutex_lock(&p->progress_mutex);
+        while (atomic_load_explicit(&p->state, memory_order_relaxed) != STATE_INPUT_READY)
+            pthread_cond_wait(&p->output_cond, &p->progress_mutex);
+        pthread_mutex_unlock(&p->progress_mutex);
+    }
+
+    av_frame_move_ref(picture, p->frame);
+    *got_picture_ptr = p->got_frame;
+    picture->pkt_dts = p->avpkt->dts;
+    err = p->result;
+    p->got_frame = 0;
+    p->result = 0;
+
+    if (++fctx->next_finished >= avctx->thread_count)
+        fctx->next_finished = 0;
+    fctx->nb_pending--;
+
+    update_context_from_thread(avctx, p->avctx, 1);
+
+    return err;
+}
+
+/**
+ * Low delay variant of ff_thread_decode_frame(): frames are returned as soon
+ * as the oldest thread has finished, and only waited for when max_delay
+ * packets are in flight, instead of after thread_count packets.
+ * To catch up when several frames are ready, a frame may be returned without
+ * taking the packet, which is then passed again in the next call; this is
+ * signalled by returning 0 with a non-empty packet.
+ */
+static int decode_frame_low_delay(AVCodecContext *avctx,
+                                  AVFrame *picture, int *got_picture_ptr,
+                                  AVPacket *avpkt)
+{
+    FrameThreadContext *fctx = avctx->internal->thread_ctx;
+    int err, submitted = 0;
+
+    *got_picture_ptr = 0;
+
+    while (fctx->nb_pending &&
+           atomic_load(&fctx->threads[fctx->next_finished].state) == STATE_INPUT_READY) {
+        err = get_oldest_frame(avctx, picture, got_picture_ptr);
+        if (err < 0) {
+            if (!avpkt->size)
+                return err;
+            fctx->deferred_result = err;
+        } else if (*got_picture_ptr) {
+            return 0;
+        }
+    }
+
+    for (;;) {
+        /* when draining, the empty packet flushes the delayed frames of the
+         * codec once all the other packets are done */
+        if (!submitted && (avpkt->size || !fctx->nb_pending)) {
+            submitted = 1;
+            /* submit_packet() drops the empty packet for codecs without
+             * delayed frames, so it does not take a thread */
+            if (avpkt->size || avctx->codec->capabilities & AV_CODEC_CAP_DELAY) {
+                err = submit_packet(&fctx->threads[fctx->next_decoding], avctx, avpkt);
+                if (err)
+                    return err;
+                if (fctx->next_decoding >= avctx->thread_count)
+                    fctx->next_decoding = 0;
+                fctx->nb_pending++;
+            }
+        }
+
+        if (!fctx->nb_pending || (avpkt->size && fctx->nb_pending < fctx->max_delay))
+            break;
+
+        err = get_oldest_frame(avctx, picture, got_picture_ptr);
+        if (err < 0) {
+            if (!avpkt->size)
+                return err;
+            fctx->deferred_result = err;
+        } else if (*got_picture_ptr || avpkt->size) {
+            break;
+        }
+    }
+
+    if (!avpkt->size)
+        return 0;
+
+    err = fctx->deferred_result;
+    fctx->deferred_result = 0;
+    return err < 0 ? err : avpkt->size;
+}
+
 int ff_thread_decode_frame(AVCodecContext *avctx,
                            AVFrame *picture, int *got_picture_ptr,
                            AVPacket *avpkt)
@@ -515,6 +619,11 @@ int ff_thread_decode_frame(AVCodecContext *avctx,
      * go forward while we are in this function */
     async_unlock(fctx);
 
+    if (fctx->max_delay) {
+        err = decode_frame_low_delay(avctx, picture, got_picture_ptr, avpkt);
+        goto finish;
+    }
+
     /*
      * Submit a packet to the next decoding thread.
      */
@@ -772,6 +881,8 @@ void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
             }
             if (codec->close && p->thread_init != UNINITIALIZED)
                 codec->close(ctx);
+            if (ctx->internal->slice_thread_ctx)
+                ff_slice_thread_free(ctx);
 
 #if FF_API_THREAD_SAFE_CALLBACKS
             release_delayed_buffers(p);
@@ -863,6 +974,13 @@ static av_cold int init_thread(PerThreadContext *p, int *threads_to_free,
     if (!first)
         copy->internal->is_copy = 1;
 
+    if (copy->active_thread_type & FF_THREAD_SLICE) {
+        copy->thread_count = avctx->frame_slice_threads;
+        err = ff_slice_thread_init(copy);
+        if (err < 0)
+            return err;
+    }
+
     if (codec->init) {
         err = codec->init(copy);
         if (err < 0) {
@@ -903,6 +1021,17 @@ int ff_frame_thread_init(AVCodecContext *avctx)
             thread_count = avctx->thread_count = 1;
     }
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        // split the threads between frame threads and their slice threads
+        thread_count = avctx->thread_count =
+            FFMAX(thread_count / avctx->frame_slice_threads, 1);
+        if (thread_count <= 1) {
+            avctx->thread_count       = avctx->frame_slice_threads;
+            avctx->active_thread_type = FF_THREAD_SLICE;
+            return ff_slice_thread_init(avctx);
+        }
+    }
+
     if (thread_count <= 1) {
         avctx->active_thread_type = 0;
         return 0;
@@ -921,9 +1050,13 @@ int ff_frame_thread_init(AVCodecContext *avctx)
 
     fctx->async_lock = 1;
     fctx->delaying = 1;
+    /* like the delaying of the classic mode, FFV1 keeps one thread idle */
+    if (avctx->frame_thread_max_delay > 0)
+        fctx->max_delay = FFMIN(avctx->frame_thread_max_delay,
+                                thread_count - (avctx->codec_id == AV_CODEC_ID_FFV1));
 
     if (codec->type == AVMEDIA_TYPE_VIDEO)
-        avctx->delay = src->thread_count - 1;
+        avctx->delay = (fctx->max_delay ? fctx->max_delay : src->thread_count) - 1;
 
     fctx->threads = av_mallocz_array(thread_count, sizeof(PerThreadContext));
     if (!fctx->threads) {
@@ -962,6 +1095,8 @@ void ff_thread_flush(AVCodecContext *avctx)
 
     fctx->next_decoding = fctx->next_finished = 0;
     fctx->delaying = 1;
+    fctx->nb_pending = 0;
+    fctx->deferred_result = 0;
     fctx->prev_thread = NULL;
     for (i = 0; i < avctx->thread_count; i++) {
         PerThreadContext *p = &fctx->threads[i];
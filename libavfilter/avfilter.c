@@ -19,6 +19,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <time.h>
+
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/buffer.h"
@@ -33,6 +35,7 @@
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 #define FF_INTERNAL_FIELDS 1
 #include "framequeue.h"
@@ -192,6 +195,15 @@ int avfilter_link_get_channels(AVFilterLink *link)
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
+    AVFilterGraphInternal *graphi = filter->graph ? filter->graph->internal : NULL;
+
+    /* filters running concurrently may share an upstream neighbour */
+    if (graphi && graphi->concurrent) {
+        ff_mutex_lock(&graphi->ready_lock);
+        filter->ready = FFMAX(filter->ready, priority);
+        ff_mutex_unlock(&graphi->ready_lock);
+        return;
+    }
     filter->ready = FFMAX(filter->ready, priority);
 }
 
@@ -1136,6 +1148,7 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
         av_frame_free(&frame);
         return ret;
     }
+    link->max_queued = FFMAX(link->max_queued, ff_framequeue_queued_frames(&link->fifo));
     ff_filter_set_ready(link->dst, 300);
     return 0;
 
@@ -1431,21 +1444,71 @@ static int ff_filter_activate_default(AVFilterContext *filter)
      [buffersrc1][testsrc1][buffersrc2][testsrc2]concat=v=2).
  */
 
+static int64_t get_thread_cpu_time(void)
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+
+    if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+        return ts.tv_sec * INT64_C(1000000) + ts.tv_nsec / 1000;
+#endif
+    return 0;
+}
+
 int ff_filter_activate(AVFilterContext *filter)
 {
+    int64_t wall_time = 0, cpu_time = 0;
     int ret;
 
     /* Generic timeline support is not yet implemented but should be easy */
     av_assert1(!(filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  filter->filter->activate));
     filter->ready = 0;
+    filter->internal->nb_activations++;
+    if (filter->graph->profile) {
+        wall_time = av_gettime_relative();
+        cpu_time  = get_thread_cpu_time();
+    }
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
+    if (filter->graph->profile) {
+        filter->internal->wall_time += av_gettime_relative() - wall_time;
+        filter->internal->cpu_time  += get_thread_cpu_time() - cpu_time;
+    }
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
 }
 
+int avfilter_get_profile(const AVFilterContext *filter, AVFilterProfile *profile)
+{
+    unsigned i;
+
+    if (!filter->graph)
+        return AVERROR(EINVAL);
+
+    memset(profile, 0, sizeof(*profile));
+    profile->nb_activations = filter->internal->nb_activations;
+    profile->wall_time      = filter->internal->wall_time;
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_THREAD_CPUTIME_ID)
+    profile->cpu_time       = filter->internal->cpu_time;
+#else
+    profile->cpu_time       = -1;
+#endif
+    for (i = 0; i < filter->nb_inputs; i++) {
+        AVFilterLink *link = filter->inputs[i];
+        if (!link)
+            continue;
+        profile->frames_in  += link->frame_count_out;
+        profile->queued     += ff_framequeue_queued_frames(&link->fifo);
+        profile->max_queued  = FFMAX(profile->max_queued, link->max_queued);
+    }
+    for (i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i])
+            profile->frames_out += filter->outputs[i]->frame_count_in;
+    return 0;
+}
+
 int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts)
 {
     *rpts = link->current_pts;
@@ -335,6 +335,14 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Run filters which do not exchange frames directly with each other
+ * concurrently, e.g. the branches following a split filter. Only applies to
+ * AVFilterGraph.thread_type, and only when libavfilter's own thread pool is
+ * used (i.e. AVFilterGraph.execute is not set).
+ */
+#define AVFILTER_THREAD_FILTER (1 << 1)
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
@@ -652,6 +660,18 @@ struct AVFilterLink {
      */
     int status_out;
 
+    /**
+     * Space in pixels the destination filter would like around the video
+     * frames sent on this link, so that it can extend the picture in place.
+     * Set with ff_video_link_set_headroom().
+     */
+    int headroom_left, headroom_top, headroom_right, headroom_bottom;
+
+    /**
+     * Highest number of frames ever queued in fifo.
+     */
+    int64_t max_queued;
+
 #endif /* FF_INTERNAL_FIELDS */
 
 };
@@ -917,6 +937,14 @@ typedef struct AVFilterGraph {
     int sink_links_count;
 
     unsigned disable_auto_convert;
+
+    /**
+     * If set, the time spent in each filter of the graph is measured and can
+     * be retrieved with avfilter_get_profile().
+     *
+     * May be set by the caller before the graph starts filtering.
+     */
+    int profile;
 } AVFilterGraph;
 
 /**
@@ -954,6 +982,61 @@ AVFilterContext *avfilter_graph_alloc_filter(AVFilterGraph *graph,
  */
 AVFilterContext *avfilter_graph_get_filter(AVFilterGraph *graph, const char *name);
 
+/**
+ * Statistics about the activity of a filter instance, filled by
+ * avfilter_get_profile().
+ */
+typedef struct AVFilterProfile {
+    /**
+     * Number of times the filter was run.
+     */
+    int64_t nb_activations;
+
+    /**
+     * Wall clock time spent running the filter, in microseconds.
+     * Only measured when AVFilterGraph.profile is set, 0 otherwise.
+     */
+    int64_t wall_time;
+
+    /**
+     * CPU time spent by the thread running the filter, in microseconds, or -1
+     * if it cannot be measured on this platform. Only measured when
+     * AVFilterGraph.profile is set. Work done by the slice threads of the
+     * graph is not included; it is accounted for in wall_time.
+     */
+    int64_t cpu_time;
+
+    /**
+     * Total number of frames taken from all the inputs of the filter.
+     */
+    int64_t frames_in;
+
+    /**
+     * Total number of frames sent on all the outputs of the filter.
+     */
+    int64_t frames_out;
+
+    /**
+     * Number of frames currently queued on all the inputs of the filter.
+     */
+    int64_t queued;
+
+    /**
+     * Highest number of frames that were ever queued at the same time on a
+     * single input of the filter.
+     */
+    int64_t max_queued;
+} AVFilterProfile;
+
+/**
+ * Get the statistics collected about a filter instance.
+ *
+ * @param filter   the filter instance, must be part of a graph
+ * @param profile  the structure to fill
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int avfilter_get_profile(const AVFilterContext *filter, AVFilterProfile *profile);
+
 /**
  * Create and add a filter instance into an existing graph.
  * The filter instance is created from the filter filt and inited
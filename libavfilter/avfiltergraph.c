@@ -50,12 +50,15 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F|V|A, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = F|V|A, .unit = "thread_type" },
+        { "filter", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FILTER }, .flags = F|V|A, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, F|V|A },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
+    { "profile",     "Measure the time spent in each filter", OFFSET(profile),
+        AV_OPT_TYPE_BOOL,  { .i64 = 0 }, 0, 1, F|V|A },
     { NULL },
 };
 
@@ -78,6 +81,12 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_run_filters(AVFilterGraph *graph, AVFilterContext **filters,
+                         int nb_filters)
+{
+    return AVERROR(ENOSYS);
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -1388,6 +1397,75 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+enum {
+    SCHED_FREE,
+    SCHED_SHARED,
+    SCHED_EXCLUSIVE,
+};
+
+static int sched_can_run(const AVFilterContext *filter)
+{
+    /* sinks update the graph-wide heap of sink links */
+    return filter->nb_outputs &&
+           !(filter->filter->flags_internal & FF_FILTER_FLAG_GRAPH_EXCLUSIVE);
+}
+
+/**
+ * Reserve the state an activation of filter may touch: its links, and
+ * through them the filters downstream (their ready field and the
+ * frame_blocked_in field of their outputs). The filters upstream only get
+ * their ready field raised, which is protected by a lock, so several
+ * filters may share them.
+ */
+static int sched_try_reserve(AVFilterContext *filter)
+{
+    unsigned i;
+
+    if (filter->internal->sched_state != SCHED_FREE)
+        return 0;
+    for (i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i]->dst->internal->sched_state != SCHED_FREE)
+            return 0;
+    for (i = 0; i < filter->nb_inputs; i++)
+        if (filter->inputs[i]->src->internal->sched_state == SCHED_EXCLUSIVE)
+            return 0;
+
+    filter->internal->sched_state = SCHED_EXCLUSIVE;
+    for (i = 0; i < filter->nb_outputs; i++)
+        filter->outputs[i]->dst->internal->sched_state = SCHED_EXCLUSIVE;
+    for (i = 0; i < filter->nb_inputs; i++)
+        filter->inputs[i]->src->internal->sched_state = SCHED_SHARED;
+    return 1;
+}
+
+static int run_concurrent(AVFilterGraph *graph, AVFilterContext *first)
+{
+    AVFilterContext *filters[MAX_FILTER_THREADS];
+    int nb_threads = graph->internal->nb_filter_threads;
+    int nb_filters = 0, ret;
+    unsigned i;
+
+    for (i = 0; i < graph->nb_filters; i++)
+        graph->filters[i]->internal->sched_state = SCHED_FREE;
+
+    sched_try_reserve(first);
+    filters[nb_filters++] = first;
+    for (i = 0; i < graph->nb_filters && nb_filters < nb_threads; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        if (filter != first && filter->ready && sched_can_run(filter) &&
+            sched_try_reserve(filter))
+            filters[nb_filters++] = filter;
+    }
+
+    if (nb_filters == 1)
+        return ff_filter_activate(first);
+
+    graph->internal->concurrent = 1;
+    ret = ff_graph_run_filters(graph, filters, nb_filters);
+    graph->internal->concurrent = 0;
+    return ret;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
     AVFilterContext *filter;
@@ -1400,5 +1478,7 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
             filter = graph->filters[i];
     if (!filter->ready)
         return AVERROR(EAGAIN);
+    if (graph->internal->nb_filter_threads > 1 && sched_can_run(filter))
+        return run_concurrent(graph, filter);
     return ff_filter_activate(filter);
 }
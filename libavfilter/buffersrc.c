@@ -267,6 +267,19 @@ unsigned av_buffersrc_get_nb_failed_requests(AVFilterContext *buffer_src)
     return ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
 }
 
+int av_buffersrc_get_headroom(AVFilterContext *ctx, int *extra_width,
+                              int *extra_top, int *extra_bottom)
+{
+    AVFilterLink *outlink;
+
+    if (!ctx->nb_outputs || !(outlink = ctx->outputs[0]) ||
+        outlink->type != AVMEDIA_TYPE_VIDEO || outlink->format < 0)
+        return AVERROR(EINVAL);
+
+    ff_video_link_get_headroom(outlink, extra_width, extra_top, extra_bottom);
+    return 0;
+}
+
 #define OFFSET(x) offsetof(BufferSourceContext, x)
 #define A AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_AUDIO_PARAM
 #define V AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
@@ -63,6 +63,27 @@ enum {
  */
 unsigned av_buffersrc_get_nb_failed_requests(AVFilterContext *buffer_src);
 
+/**
+ * Get the padding the filters downstream of a configured video buffer source
+ * would like to find around the frames sent to it.
+ *
+ * Frames whose planes are allocated (w + extra_width) x
+ * (h + extra_top + extra_bottom) pixels large, with the picture starting at
+ * line extra_top of the allocation, writable and with data pointing to the
+ * top-left pixel of the picture, may be padded in place instead of copied.
+ * Sending frames without such headroom is always valid.
+ *
+ * @param ctx          an instance of the buffersrc filter, after the graph
+ *                     has been configured
+ * @param extra_width  set to the number of extra pixels per line
+ * @param extra_top    set to the number of extra lines above the picture
+ * @param extra_bottom set to the number of extra lines below the picture
+ * @return 0 on success, AVERROR(EINVAL) if ctx is not a configured video
+ *         buffer source
+ */
+int av_buffersrc_get_headroom(AVFilterContext *ctx, int *extra_width,
+                              int *extra_top, int *extra_bottom);
+
 /**
  * This structure contains the parameters describing the frames that will be
  * passed to this filter.
@@ -234,6 +234,7 @@ AVFilter ff_vf_zmq = {
     .inputs      = zmq_inputs,
     .outputs     = zmq_outputs,
     .priv_class  = &zmq_class,
+    .flags_internal = FF_FILTER_FLAG_GRAPH_EXCLUSIVE,
 };
 
 #endif
@@ -269,6 +270,7 @@ AVFilter ff_af_azmq = {
     .inputs      = azmq_inputs,
     .outputs     = azmq_outputs,
     .priv_class  = &azmq_class,
+    .flags_internal = FF_FILTER_FLAG_GRAPH_EXCLUSIVE,
 };
 
 #endif
@@ -25,6 +25,7 @@
  */
 
 #include "libavutil/internal.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "framepool.h"
@@ -130,10 +131,37 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * Maximum number of filters activated concurrently, 0 if the graph does
+     * not use AVFILTER_THREAD_FILTER.
+     */
+    int nb_filter_threads;
+
+    /**
+     * Set while several filters are being activated concurrently, in which
+     * case ready_lock protects the ready field of the filters.
+     */
+    int concurrent;
+    AVMutex ready_lock;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Statistics reported by avfilter_get_profile(); the times are only
+     * accumulated when AVFilterGraph.profile is set.
+     */
+    int64_t nb_activations;
+    int64_t wall_time;
+    int64_t cpu_time;
+
+    /**
+     * Used by ff_filter_graph_run_once() to pick filters which can be
+     * activated concurrently.
+     */
+    int sched_state;
 };
 
 /**
@@ -338,6 +366,21 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter accesses other filters of the graph than its direct neighbours
+ * while filtering (e.g. to send them commands or to read the state of their
+ * links), and therefore must not be activated concurrently with any other
+ * filter.
+ */
+#define FF_FILTER_FLAG_GRAPH_EXCLUSIVE (1 << 1)
+
+/**
+ * The filter passes the frames of its single input to its single output
+ * without touching their data, only their properties, so requests for
+ * room around the frames of its output also apply to its input.
+ */
+#define FF_FILTER_FLAG_METADATA_ONLY (1 << 2)
+
 /**
  * Run one round of processing on a filter graph.
  */
@@ -23,6 +23,8 @@
 
 #include "config.h"
 
+#include <stdatomic.h>
+
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/mem.h"
@@ -42,6 +44,14 @@ typedef struct ThreadContext {
     AVFilterContext *ctx;
     void *arg;
     int   *rets;
+
+    /* set while a filter uses the slice threads */
+    atomic_int busy;
+
+    /* AVFILTER_THREAD_FILTER */
+    AVSliceThread *filter_thread;
+    AVFilterContext **filters;
+    int filter_rets[MAX_FILTER_THREADS];
 } ThreadContext;
 
 static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
@@ -52,29 +62,65 @@ static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb
         c->rets[jobnr] = ret;
 }
 
+static void filter_worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ThreadContext *c = priv;
+    c->filter_rets[jobnr] = ff_filter_activate(c->filters[jobnr]);
+}
+
 static void slice_thread_uninit(ThreadContext *c)
 {
     avpriv_slicethread_free(&c->thread);
+    avpriv_slicethread_free(&c->filter_thread);
 }
 
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
                           void *arg, int *ret, int nb_jobs)
 {
     ThreadContext *c = ctx->graph->internal->thread;
+    int busy = 0, i;
 
     if (nb_jobs <= 0)
         return 0;
+
+    /* filters activated concurrently may compete for the slice threads,
+     * the ones which do not get them run their jobs serially */
+    if (!atomic_compare_exchange_strong(&c->busy, &busy, 1)) {
+        for (i = 0; i < nb_jobs; i++) {
+            int r = func(ctx, arg, i, nb_jobs);
+            if (ret)
+                ret[i] = r;
+        }
+        return 0;
+    }
+
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+    atomic_store(&c->busy, 0);
+    return 0;
+}
+
+int ff_graph_run_filters(AVFilterGraph *graph, AVFilterContext **filters,
+                         int nb_filters)
+{
+    ThreadContext *c = graph->internal->thread;
+    int i;
+
+    c->filters = filters;
+    avpriv_slicethread_execute(c->filter_thread, nb_filters, 0);
+    for (i = 0; i < nb_filters; i++)
+        if (c->filter_rets[i] < 0)
+            return c->filter_rets[i];
     return 0;
 }
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
+    atomic_init(&c->busy, 0);
     nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
@@ -105,6 +151,21 @@ int ff_graph_thread_init(AVFilterGraph *graph)
 
     graph->internal->thread_execute = thread_execute;
 
+    if (graph->thread_type & AVFILTER_THREAD_FILTER) {
+        ThreadContext *c = graph->internal->thread;
+
+        ret = avpriv_slicethread_create(&c->filter_thread, c, filter_worker_func,
+                                        NULL, FFMIN(graph->nb_threads, MAX_FILTER_THREADS));
+        if (ret < 0)
+            return ret;
+        ret = ff_mutex_init(&graph->internal->ready_lock, NULL);
+        if (ret) {
+            avpriv_slicethread_free(&c->filter_thread);
+            return AVERROR(ret);
+        }
+        graph->internal->nb_filter_threads = FFMIN(graph->nb_threads, MAX_FILTER_THREADS);
+    }
+
     return 0;
 }
 
@@ -113,4 +174,7 @@ void ff_graph_thread_free(AVFilterGraph *graph)
     if (graph->internal->thread)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
+    if (graph->internal->nb_filter_threads)
+        ff_mutex_destroy(&graph->internal->ready_lock);
+    graph->internal->nb_filter_threads = 0;
 }
@@ -302,6 +302,7 @@ AVFilter ff_vf_setpts = {
 
     .inputs    = avfilter_vf_setpts_inputs,
     .outputs   = avfilter_vf_setpts_outputs,
+    .flags_internal = FF_FILTER_FLAG_METADATA_ONLY,
 };
 #endif /* CONFIG_SETPTS_FILTER */
 
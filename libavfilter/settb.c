@@ -187,6 +187,7 @@ AVFilter ff_vf_settb = {
     .inputs      = avfilter_vf_settb_inputs,
     .outputs     = avfilter_vf_settb_outputs,
     .activate    = activate,
+    .flags_internal = FF_FILTER_FLAG_METADATA_ONLY,
 };
 #endif /* CONFIG_SETTB_FILTER */
 
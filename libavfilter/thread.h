@@ -21,8 +21,20 @@
 
 #include "avfilter.h"
 
+#define MAX_FILTER_THREADS 32
+
 int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Activate filters concurrently on the graph's filter threads.
+ *
+ * The filters must not share any state, see ff_filter_graph_run_once().
+ *
+ * @return 0 on success, or the first error returned by ff_filter_activate()
+ */
+int ff_graph_run_filters(AVFilterGraph *graph, AVFilterContext **filters,
+                         int nb_filters);
+
 #endif /* AVFILTER_THREAD_H */
@@ -192,6 +192,7 @@ AVFilter ff_vf_setdar = {
     .priv_class  = &setdar_class,
     .inputs      = avfilter_vf_setdar_inputs,
     .outputs     = avfilter_vf_setdar_outputs,
+    .flags_internal = FF_FILTER_FLAG_METADATA_ONLY,
 };
 
 #endif /* CONFIG_SETDAR_FILTER */
@@ -256,6 +257,7 @@ AVFilter ff_vf_setsar = {
     .priv_class  = &setsar_class,
     .inputs      = avfilter_vf_setsar_inputs,
     .outputs     = avfilter_vf_setsar_outputs,
+    .flags_internal = FF_FILTER_FLAG_METADATA_ONLY,
 };
 
 #endif /* CONFIG_SETSAR_FILTER */
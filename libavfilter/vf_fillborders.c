@@ -52,7 +52,7 @@ typedef struct FillBordersContext {
     uint8_t yuv_color[4];
     uint8_t rgba_color[4];
 
-    void (*fillborders)(struct FillBordersContext *s, AVFrame *frame);
+    void (*fillborders)(struct FillBordersContext *s, AVFrame *frame, int p, int y0, int y1);
 } FillBordersContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -84,15 +84,27 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, fmts_list);
 }
 
-static void smear_borders8(FillBordersContext *s, AVFrame *frame)
-{
-    int p, y;
+/*
+ * The fill functions process the rows [y0, y1) of plane p. A row in the
+ * top or bottom border may read the interior rows, so those have to be
+ * finished first, see filter_frame().
+ */
 
-    for (p = 0; p < s->nb_planes; p++) {
-        uint8_t *ptr = frame->data[p];
-        int linesize = frame->linesize[p];
+static void smear_borders8(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
+{
+    uint8_t *ptr = frame->data[p];
+    int linesize = frame->linesize[p];
+    int y;
 
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + s->borders[p].top * linesize, s->planewidth[p]);
+        } else if (y >= s->planeheight[p] - s->borders[p].bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->planeheight[p] - s->borders[p].bottom - 1) * linesize,
+                   s->planewidth[p]);
+        } else {
             memset(ptr + y * linesize,
                    *(ptr + y * linesize + s->borders[p].left),
                    s->borders[p].left);
@@ -100,29 +112,24 @@ static void smear_borders8(FillBordersContext *s, AVFrame *frame)
                    *(ptr + y * linesize + s->planewidth[p] - s->borders[p].right - 1),
                    s->borders[p].right);
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + s->borders[p].top * linesize, s->planewidth[p]);
-        }
-
-        for (y = s->planeheight[p] - s->borders[p].bottom; y < s->planeheight[p]; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - 1) * linesize,
-                   s->planewidth[p]);
-        }
     }
 }
 
-static void smear_borders16(FillBordersContext *s, AVFrame *frame)
+static void smear_borders16(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint16_t *ptr = (uint16_t *)frame->data[p];
-        int linesize = frame->linesize[p] / 2;
+    uint16_t *ptr = (uint16_t *)frame->data[p];
+    int linesize = frame->linesize[p] / 2;
+    int y, x;
 
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + s->borders[p].top * linesize, s->planewidth[p] * 2);
+        } else if (y >= s->planeheight[p] - s->borders[p].bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->planeheight[p] - s->borders[p].bottom - 1) * linesize,
+                   s->planewidth[p] * 2);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] =  *(ptr + y * linesize + s->borders[p].left);
             }
@@ -132,29 +139,26 @@ static void smear_borders16(FillBordersContext *s, AVFrame *frame)
                    *(ptr + y * linesize + s->planewidth[p] - s->borders[p].right - 1);
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + s->borders[p].top * linesize, s->planewidth[p] * 2);
-        }
-
-        for (y = s->planeheight[p] - s->borders[p].bottom; y < s->planeheight[p]; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - 1) * linesize,
-                   s->planewidth[p] * 2);
-        }
     }
 }
 
-static void mirror_borders8(FillBordersContext *s, AVFrame *frame)
+static void mirror_borders8(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
+    uint8_t *ptr = frame->data[p];
+    int linesize = frame->linesize[p];
+    int bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
 
-    for (p = 0; p < s->nb_planes; p++) {
-        uint8_t *ptr = frame->data[p];
-        int linesize = frame->linesize[p];
-
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->borders[p].top * 2 - 1 - y) * linesize,
+                   s->planewidth[p]);
+        } else if (y >= bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (bottom - 1 - (y - bottom)) * linesize,
+                   s->planewidth[p]);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = ptr[y * linesize + s->borders[p].left * 2 - 1 - x];
             }
@@ -164,30 +168,26 @@ static void mirror_borders8(FillBordersContext *s, AVFrame *frame)
                     ptr[y * linesize + s->planewidth[p] - s->borders[p].right - 1 - x];
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->borders[p].top * 2 - 1 - y) * linesize,
-                   s->planewidth[p]);
-        }
-
-        for (y = 0; y < s->borders[p].bottom; y++) {
-            memcpy(ptr + (s->planeheight[p] - s->borders[p].bottom + y) * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - 1 - y) * linesize,
-                   s->planewidth[p]);
-        }
     }
 }
 
-static void mirror_borders16(FillBordersContext *s, AVFrame *frame)
+static void mirror_borders16(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint16_t *ptr = (uint16_t *)frame->data[p];
-        int linesize = frame->linesize[p] / 2;
+    uint16_t *ptr = (uint16_t *)frame->data[p];
+    int linesize = frame->linesize[p] / 2;
+    int bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
 
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->borders[p].top * 2 - 1 - y) * linesize,
+                   s->planewidth[p] * 2);
+        } else if (y >= bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (bottom - 1 - (y - bottom)) * linesize,
+                   s->planewidth[p] * 2);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = ptr[y * linesize + s->borders[p].left * 2 - 1 - x];
             }
@@ -197,56 +197,42 @@ static void mirror_borders16(FillBordersContext *s, AVFrame *frame)
                     ptr[y * linesize + s->planewidth[p] - s->borders[p].right - 1 - x];
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->borders[p].top * 2 - 1 - y) * linesize,
-                   s->planewidth[p] * 2);
-        }
-
-        for (y = 0; y < s->borders[p].bottom; y++) {
-            memcpy(ptr + (s->planeheight[p] - s->borders[p].bottom + y) * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - 1 - y) * linesize,
-                   s->planewidth[p] * 2);
-        }
     }
 }
 
-static void fixed_borders8(FillBordersContext *s, AVFrame *frame)
+static void fixed_borders8(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint8_t *ptr = frame->data[p];
-        uint8_t fill = s->fill[p];
-        int linesize = frame->linesize[p];
-
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    uint8_t *ptr = frame->data[p];
+    uint8_t fill = s->fill[p];
+    int linesize = frame->linesize[p];
+    int y;
+
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top ||
+            y >= s->planeheight[p] - s->borders[p].bottom) {
+            memset(ptr + y * linesize, fill, s->planewidth[p]);
+        } else {
             memset(ptr + y * linesize, fill, s->borders[p].left);
             memset(ptr + y * linesize + s->planewidth[p] - s->borders[p].right, fill,
                    s->borders[p].right);
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memset(ptr + y * linesize, fill, s->planewidth[p]);
-        }
-
-        for (y = s->planeheight[p] - s->borders[p].bottom; y < s->planeheight[p]; y++) {
-            memset(ptr + y * linesize, fill, s->planewidth[p]);
-        }
     }
 }
 
-static void fixed_borders16(FillBordersContext *s, AVFrame *frame)
+static void fixed_borders16(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint16_t *ptr = (uint16_t *)frame->data[p];
-        uint16_t fill = s->fill[p] << (s->depth - 8);
-        int linesize = frame->linesize[p] / 2;
-
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    uint16_t *ptr = (uint16_t *)frame->data[p];
+    uint16_t fill = s->fill[p] << (s->depth - 8);
+    int linesize = frame->linesize[p] / 2;
+    int y, x;
+
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top ||
+            y >= s->planeheight[p] - s->borders[p].bottom) {
+            for (x = 0; x < s->planewidth[p]; x++) {
+                ptr[y * linesize + x] = fill;
+            }
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = fill;
             }
@@ -255,30 +241,26 @@ static void fixed_borders16(FillBordersContext *s, AVFrame *frame)
                 ptr[y * linesize + s->planewidth[p] - s->borders[p].right + x] = fill;
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            for (x = 0; x < s->planewidth[p]; x++) {
-                ptr[y * linesize + x] = fill;
-            }
-        }
-
-        for (y = s->planeheight[p] - s->borders[p].bottom; y < s->planeheight[p]; y++) {
-            for (x = 0; x < s->planewidth[p]; x++) {
-                ptr[y * linesize + x] = fill;
-            }
-        }
     }
 }
 
-static void reflect_borders8(FillBordersContext *s, AVFrame *frame)
+static void reflect_borders8(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
+    uint8_t *ptr = frame->data[p];
+    int linesize = frame->linesize[p];
+    int bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
 
-    for (p = 0; p < s->nb_planes; p++) {
-        uint8_t *ptr = frame->data[p];
-        int linesize = frame->linesize[p];
-
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->borders[p].top * 2 - y) * linesize,
+                   s->planewidth[p]);
+        } else if (y >= bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (bottom - 2 - (y - bottom)) * linesize,
+                   s->planewidth[p]);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = ptr[y * linesize + s->borders[p].left * 2 - x];
             }
@@ -288,30 +270,26 @@ static void reflect_borders8(FillBordersContext *s, AVFrame *frame)
                     ptr[y * linesize + s->planewidth[p] - s->borders[p].right - 2 - x];
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->borders[p].top * 2 - y) * linesize,
-                   s->planewidth[p]);
-        }
-
-        for (y = 0; y < s->borders[p].bottom; y++) {
-            memcpy(ptr + (s->planeheight[p] - s->borders[p].bottom + y) * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - 2 - y) * linesize,
-                   s->planewidth[p]);
-        }
     }
 }
 
-static void reflect_borders16(FillBordersContext *s, AVFrame *frame)
+static void reflect_borders16(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
+    uint16_t *ptr = (uint16_t *)frame->data[p];
+    int linesize = frame->linesize[p] / 2;
+    int bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
 
-    for (p = 0; p < s->nb_planes; p++) {
-        uint16_t *ptr = (uint16_t *)frame->data[p];
-        int linesize = frame->linesize[p] / 2;
-
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->borders[p].top * 2 - y) * linesize,
+                   s->planewidth[p] * 2);
+        } else if (y >= bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (bottom - 2 - (y - bottom)) * linesize,
+                   s->planewidth[p] * 2);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = ptr[y * linesize + s->borders[p].left * 2 - x];
             }
@@ -321,30 +299,26 @@ static void reflect_borders16(FillBordersContext *s, AVFrame *frame)
                     ptr[y * linesize + s->planewidth[p] - s->borders[p].right - 2 - x];
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->borders[p].top * 2 - y) * linesize,
-                   s->planewidth[p] * 2);
-        }
-
-        for (y = 0; y < s->borders[p].bottom; y++) {
-            memcpy(ptr + (s->planeheight[p] - s->borders[p].bottom + y) * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - 2 - y) * linesize,
-                   s->planewidth[p] * 2);
-        }
     }
 }
 
-static void wrap_borders8(FillBordersContext *s, AVFrame *frame)
+static void wrap_borders8(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint8_t *ptr = frame->data[p];
-        int linesize = frame->linesize[p];
+    uint8_t *ptr = frame->data[p];
+    int linesize = frame->linesize[p];
+    int bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
 
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + (bottom - s->borders[p].top + y) * linesize,
+                   s->planewidth[p]);
+        } else if (y >= bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->borders[p].top + y - bottom) * linesize,
+                   s->planewidth[p]);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = ptr[y * linesize + s->planewidth[p] - s->borders[p].right - s->borders[p].left + x];
             }
@@ -354,30 +328,26 @@ static void wrap_borders8(FillBordersContext *s, AVFrame *frame)
                     ptr[y * linesize + s->borders[p].left + x];
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - s->borders[p].top + y) * linesize,
-                   s->planewidth[p]);
-        }
-
-        for (y = 0; y < s->borders[p].bottom; y++) {
-            memcpy(ptr + (s->planeheight[p] - s->borders[p].bottom + y) * linesize,
-                   ptr + (s->borders[p].top + y) * linesize,
-                   s->planewidth[p]);
-        }
     }
 }
 
-static void wrap_borders16(FillBordersContext *s, AVFrame *frame)
+static void wrap_borders16(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
+    uint16_t *ptr = (uint16_t *)frame->data[p];
+    int linesize = frame->linesize[p] / 2;
+    int bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
 
-    for (p = 0; p < s->nb_planes; p++) {
-        uint16_t *ptr = (uint16_t *)frame->data[p];
-        int linesize = frame->linesize[p] / 2;
-
-        for (y = s->borders[p].top; y < s->planeheight[p] - s->borders[p].bottom; y++) {
+    for (y = y0; y < y1; y++) {
+        if (y < s->borders[p].top) {
+            memcpy(ptr + y * linesize,
+                   ptr + (bottom - s->borders[p].top + y) * linesize,
+                   s->planewidth[p] * 2);
+        } else if (y >= bottom) {
+            memcpy(ptr + y * linesize,
+                   ptr + (s->borders[p].top + y - bottom) * linesize,
+                   s->planewidth[p] * 2);
+        } else {
             for (x = 0; x < s->borders[p].left; x++) {
                 ptr[y * linesize + x] = ptr[y * linesize + s->planewidth[p] - s->borders[p].right - s->borders[p].left + x];
             }
@@ -387,18 +357,6 @@ static void wrap_borders16(FillBordersContext *s, AVFrame *frame)
                     ptr[y * linesize + s->borders[p].left + x];
             }
         }
-
-        for (y = 0; y < s->borders[p].top; y++) {
-            memcpy(ptr + y * linesize,
-                   ptr + (s->planeheight[p] - s->borders[p].bottom - s->borders[p].top + y) * linesize,
-                   s->planewidth[p] * 2);
-        }
-
-        for (y = 0; y < s->borders[p].bottom; y++) {
-            memcpy(ptr + (s->planeheight[p] - s->borders[p].bottom + y) * linesize,
-                   ptr + (s->borders[p].top + y) * linesize,
-                   s->planewidth[p] * 2);
-        }
     }
 }
 
@@ -412,94 +370,153 @@ static int lerp16(int fill, int src, int pos, int size, int depth)
     return av_clip_uintp2_c(((fill * (1LL << depth) * pos / size) + (src * (1LL << depth) * (size - pos) / size)) >> depth, depth);
 }
 
-static void fade_borders8(FillBordersContext *s, AVFrame *frame)
+/* fade only reads the pixels it writes, so all rows are independent */
+static void fade_borders8(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
-    int p, y, x;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint8_t *ptr = frame->data[p];
-        const uint8_t fill = s->fill[p];
-        const int linesize = frame->linesize[p];
-        const int start_left = s->borders[p].left;
-        const int start_right = s->planewidth[p] - s->borders[p].right;
-        const int start_top = s->borders[p].top;
-        const int start_bottom = s->planeheight[p] - s->borders[p].bottom;
-
-        for (y = 0; y < start_top; y++) {
+    uint8_t *ptr = frame->data[p];
+    const uint8_t fill = s->fill[p];
+    const int linesize = frame->linesize[p];
+    const int start_left = s->borders[p].left;
+    const int start_right = s->planewidth[p] - s->borders[p].right;
+    const int start_top = s->borders[p].top;
+    const int start_bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
+
+    for (y = y0; y < y1; y++) {
+        if (y < start_top) {
             for (x = 0; x < s->planewidth[p]; x++) {
                 int src = ptr[y * linesize + x];
                 ptr[y * linesize + x] = lerp8(fill, src, start_top - y, start_top);
             }
-        }
-
-        for (y = start_bottom; y < s->planeheight[p]; y++) {
+        } else if (y >= start_bottom) {
             for (x = 0; x < s->planewidth[p]; x++) {
                 int src = ptr[y * linesize + x];
                 ptr[y * linesize + x] = lerp8(fill, src, y - start_bottom, s->borders[p].bottom);
             }
         }
 
-        for (y = 0; y < s->planeheight[p]; y++) {
-            for (x = 0; x < start_left; x++) {
-                int src = ptr[y * linesize + x];
-                ptr[y * linesize + x] = lerp8(fill, src, start_left - x, start_left);
-            }
+        for (x = 0; x < start_left; x++) {
+            int src = ptr[y * linesize + x];
+            ptr[y * linesize + x] = lerp8(fill, src, start_left - x, start_left);
+        }
 
-            for (x = 0; x < s->borders[p].right; x++) {
-                int src = ptr[y * linesize + start_right + x];
-                ptr[y * linesize + start_right + x] = lerp8(fill, src, x, s->borders[p].right);
-            }
+        for (x = 0; x < s->borders[p].right; x++) {
+            int src = ptr[y * linesize + start_right + x];
+            ptr[y * linesize + start_right + x] = lerp8(fill, src, x, s->borders[p].right);
         }
     }
 }
 
-static void fade_borders16(FillBordersContext *s, AVFrame *frame)
+static void fade_borders16(FillBordersContext *s, AVFrame *frame, int p, int y0, int y1)
 {
     const int depth = s->depth;
-    int p, y, x;
-
-    for (p = 0; p < s->nb_planes; p++) {
-        uint16_t *ptr = (uint16_t *)frame->data[p];
-        const uint16_t fill = s->fill[p] << (depth - 8);
-        const int linesize = frame->linesize[p] / 2;
-        const int start_left = s->borders[p].left;
-        const int start_right = s->planewidth[p] - s->borders[p].right;
-        const int start_top = s->borders[p].top;
-        const int start_bottom = s->planeheight[p] - s->borders[p].bottom;
-
-        for (y = 0; y < start_top; y++) {
+    uint16_t *ptr = (uint16_t *)frame->data[p];
+    const uint16_t fill = s->fill[p] << (depth - 8);
+    const int linesize = frame->linesize[p] / 2;
+    const int start_left = s->borders[p].left;
+    const int start_right = s->planewidth[p] - s->borders[p].right;
+    const int start_top = s->borders[p].top;
+    const int start_bottom = s->planeheight[p] - s->borders[p].bottom;
+    int y, x;
+
+    for (y = y0; y < y1; y++) {
+        if (y < start_top) {
             for (x = 0; x < s->planewidth[p]; x++) {
                 int src = ptr[y * linesize + x];
                 ptr[y * linesize + x] = lerp16(fill, src, start_top - y, start_top, depth);
             }
-        }
-
-        for (y = start_bottom; y < s->planeheight[p]; y++) {
+        } else if (y >= start_bottom) {
             for (x = 0; x < s->planewidth[p]; x++) {
                 int src = ptr[y * linesize + x];
                 ptr[y * linesize + x] = lerp16(fill, src, y - start_bottom, s->borders[p].bottom, depth);
             }
         }
 
-        for (y = 0; y < s->planeheight[p]; y++) {
-            for (x = 0; x < start_left; x++) {
-                int src = ptr[y * linesize + x];
-                ptr[y * linesize + x] = lerp16(fill, src, start_left - x, start_left, depth);
-            }
+        for (x = 0; x < start_left; x++) {
+            int src = ptr[y * linesize + x];
+            ptr[y * linesize + x] = lerp16(fill, src, start_left - x, start_left, depth);
+        }
 
-            for (x = 0; x < s->borders[p].right; x++) {
-                int src = ptr[y * linesize + start_right + x];
-                ptr[y * linesize + start_right + x] = lerp16(fill, src, x, s->borders[p].right, depth);
-            }
+        for (x = 0; x < s->borders[p].right; x++) {
+            int src = ptr[y * linesize + start_right + x];
+            ptr[y * linesize + start_right + x] = lerp16(fill, src, x, s->borders[p].right, depth);
+        }
+    }
+}
+
+enum FillStage {
+    STAGE_ALL,      ///< every row, for the modes not reading other rows
+    STAGE_INTERIOR, ///< left and right borders of the rows between top and bottom
+    STAGE_TOPBOTTOM ///< top and bottom borders, after STAGE_INTERIOR
+};
+
+typedef struct ThreadData {
+    AVFrame *frame;
+    enum FillStage stage;
+} ThreadData;
+
+static int fill_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FillBordersContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int p;
+
+    for (p = 0; p < s->nb_planes; p++) {
+        const int top    = s->borders[p].top;
+        const int bottom = s->borders[p].bottom;
+        const int height = s->planeheight[p];
+
+        switch (td->stage) {
+        case STAGE_ALL:
+            s->fillborders(s, td->frame, p, (height *  jobnr   ) / nb_jobs,
+                                            (height * (jobnr+1)) / nb_jobs);
+            break;
+        case STAGE_INTERIOR: {
+            const int h = height - top - bottom;
+            s->fillborders(s, td->frame, p, top + (h *  jobnr   ) / nb_jobs,
+                                            top + (h * (jobnr+1)) / nb_jobs);
+            break;
+        }
+        case STAGE_TOPBOTTOM:
+            s->fillborders(s, td->frame, p, (top *  jobnr   ) / nb_jobs,
+                                            (top * (jobnr+1)) / nb_jobs);
+            s->fillborders(s, td->frame, p, height - bottom + (bottom *  jobnr   ) / nb_jobs,
+                                            height - bottom + (bottom * (jobnr+1)) / nb_jobs);
+            break;
         }
     }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
-    FillBordersContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    FillBordersContext *s = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    ThreadData td = { .frame = frame };
 
-    s->fillborders(s, frame);
+    if (s->mode == FM_FADE || s->mode == FM_FIXED) {
+        td.stage = STAGE_ALL;
+        ctx->internal->execute(ctx, fill_slice, &td, NULL,
+                               FFMIN(s->planeheight[1], nb_threads));
+    } else {
+        const int top = s->top, bottom = s->bottom, h = inlink->h;
+        int nb_jobs = FFMIN(FFMAX(top, bottom), nb_threads);
+
+        td.stage = STAGE_INTERIOR;
+        ctx->internal->execute(ctx, fill_slice, &td, NULL,
+                               FFMAX(1, FFMIN(s->planeheight[1] - s->borders[1].top - s->borders[1].bottom,
+                                              nb_threads)));
+
+        /* with large borders the rows copied into a border may themselves be
+         * border rows, keep the sequential order then */
+        if (h <= 2 * top + bottom || h <= top + 2 * bottom)
+            nb_jobs = 1;
+        td.stage = STAGE_TOPBOTTOM;
+        if (top || bottom)
+            ctx->internal->execute(ctx, fill_slice, &td, NULL, FFMAX(1, nb_jobs));
+    }
 
     return ff_filter_frame(inlink->dst->outputs[0], frame);
 }
@@ -636,6 +653,6 @@ AVFilter ff_vf_fillborders = {
     .query_formats = query_formats,
     .inputs        = fillborders_inputs,
     .outputs       = fillborders_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
     .process_command = process_command,
 };
@@ -207,6 +207,12 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
+    /* ask for frames with room for the borders, so that they can be padded
+     * in place */
+    ff_video_link_set_headroom(inlink, s->x, s->y,
+                               s->w - s->x - s->in_w,
+                               s->h - s->y - s->in_h);
+
     return 0;
 
 eval_fail:
@@ -225,35 +231,6 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static AVFrame *get_video_buffer(AVFilterLink *inlink, int w, int h)
-{
-    PadContext *s = inlink->dst->priv;
-    AVFrame *frame;
-    int plane;
-
-    if (s->inlink_w <= 0)
-        return NULL;
-
-    frame = ff_get_video_buffer(inlink->dst->outputs[0],
-                                w + (s->w - s->in_w),
-                                h + (s->h - s->in_h) + (s->x > 0));
-
-    if (!frame)
-        return NULL;
-
-    frame->width  = w;
-    frame->height = h;
-
-    for (plane = 0; plane < 4 && frame->data[plane] && frame->linesize[plane]; plane++) {
-        int hsub = s->draw.hsub[plane];
-        int vsub = s->draw.vsub[plane];
-        frame->data[plane] += (s->x >> hsub) * s->draw.pixelstep[plane] +
-                              (s->y >> vsub) * frame->linesize[plane];
-    }
-
-    return frame;
-}
-
 /* check whether each plane in this buffer can be padded without copying */
 static int buffer_needs_copy(PadContext *s, AVFrame *frame, AVBufferRef *buf)
 {
@@ -320,11 +297,69 @@ static int frame_needs_copy(PadContext *s, AVFrame *frame)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int needs_copy;
+} ThreadData;
+
+/* Fill and copy the output rows of one slice. The slice boundaries are
+ * aligned to the chroma subsampling like all the rectangles below. */
+static int pad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PadContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in, *out = td->out;
+    const int align = 1 << s->draw.vsub_max;
+    const int nb_rows = s->h / align;
+    const int slice_start = nb_rows * jobnr / nb_jobs * align;
+    const int slice_end = jobnr == nb_jobs - 1 ? s->h : nb_rows * (jobnr + 1) / nb_jobs * align;
+    int y0, y1;
+
+    /* top bar */
+    y1 = FFMIN(s->y, slice_end);
+    if (slice_start < y1) {
+        ff_fill_rectangle(&s->draw, &s->color,
+                          out->data, out->linesize,
+                          0, slice_start, s->w, y1 - slice_start);
+    }
+
+    /* bottom bar */
+    y0 = FFMAX(s->y + s->in_h, slice_start);
+    if (y0 < slice_end) {
+        ff_fill_rectangle(&s->draw, &s->color,
+                          out->data, out->linesize,
+                          0, y0, s->w, slice_end - y0);
+    }
+
+    y0 = FFMAX(s->y, slice_start);
+    y1 = FFMIN(s->y + in->height, slice_end);
+    if (y0 >= y1)
+        return 0;
+
+    /* left border */
+    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
+                      0, y0, s->x, y1 - y0);
+
+    if (td->needs_copy) {
+        ff_copy_rectangle2(&s->draw,
+                          out->data, out->linesize, in->data, in->linesize,
+                          s->x, y0, 0, y0 - s->y, in->width, y1 - y0);
+    }
+
+    /* right border */
+    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
+                      s->x + s->in_w, y0, s->w - s->x - s->in_w,
+                      y1 - y0);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     PadContext *s = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
+    ThreadData td;
     int needs_copy;
     if(s->eval_mode == EVAL_MODE_FRAME && (
            in->width  != s->inlink_w
@@ -376,34 +411,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
     }
 
-    /* top bar */
-    if (s->y) {
-        ff_fill_rectangle(&s->draw, &s->color,
-                          out->data, out->linesize,
-                          0, 0, s->w, s->y);
-    }
-
-    /* bottom bar */
-    if (s->h > s->y + s->in_h) {
-        ff_fill_rectangle(&s->draw, &s->color,
-                          out->data, out->linesize,
-                          0, s->y + s->in_h, s->w, s->h - s->y - s->in_h);
-    }
-
-    /* left border */
-    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
-                      0, s->y, s->x, in->height);
-
-    if (needs_copy) {
-        ff_copy_rectangle2(&s->draw,
-                          out->data, out->linesize, in->data, in->linesize,
-                          s->x, s->y, 0, 0, in->width, in->height);
-    }
-
-    /* right border */
-    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
-                      s->x + s->in_w, s->y, s->w - s->x - s->in_w,
-                      in->height);
+    td.in = in;
+    td.out = out;
+    td.needs_copy = needs_copy;
+    inlink->dst->internal->execute(inlink->dst, pad_slice, &td, NULL,
+                                   FFMAX(1, FFMIN(s->h >> s->draw.vsub_max,
+                                                  ff_filter_get_nb_threads(inlink->dst))));
 
     out->width  = s->w;
     out->height = s->h;
@@ -438,7 +451,6 @@ static const AVFilterPad avfilter_vf_pad_inputs[] = {
         .name             = "default",
         .type             = AVMEDIA_TYPE_VIDEO,
         .config_props     = config_input,
-        .get_video_buffer = get_video_buffer,
         .filter_frame     = filter_frame,
     },
     { NULL }
@@ -461,4 +473,5 @@ AVFilter ff_vf_pad = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_pad_inputs,
     .outputs       = avfilter_vf_pad_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -546,6 +546,7 @@ static int config_props(AVFilterLink *outlink)
             av_opt_set_int(*s, "sws_flags", scale->flags, 0);
             av_opt_set_int(*s, "param0", scale->param[0], 0);
             av_opt_set_int(*s, "param1", scale->param[1], 0);
+            av_opt_set_int(*s, "threads", ff_filter_get_nb_threads(ctx), 0);
             if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
                 av_opt_set_int(*s, "src_range",
                                scale->in_range == AVCOL_RANGE_JPEG, 0);
@@ -647,6 +648,11 @@ static int scale_slice(AVFilterLink *link, AVFrame *out_buf, AVFrame *cur_pic, s
                          out,out_stride);
 }
 
+static void set_systematic_pal(AVFilterLink *outlink, AVFrame *out)
+{
+    avpriv_set_systematic_pal2((uint32_t*)out->data[1], outlink->format == AV_PIX_FMT_PAL8 ? AV_PIX_FMT_BGR8 : outlink->format);
+}
+
 static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
 {
     AVFilterContext *ctx = link->dst;
@@ -657,6 +663,8 @@ static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
     char buf[32];
     int in_range;
     int frame_changed;
+    int interlaced;
+    int ret = 0;
 
     *frame_out = NULL;
     if (in->colorspace == AVCOL_SPC_YCGCO)
@@ -669,7 +677,6 @@ static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
                     in->sample_aspect_ratio.num != link->sample_aspect_ratio.num;
 
     if (scale->eval_mode == EVAL_MODE_FRAME || frame_changed) {
-        int ret;
         unsigned vars_w[VARS_NB] = { 0 }, vars_h[VARS_NB] = { 0 };
 
         av_expr_count_vars(scale->w_pexpr, vars_w, VARS_NB);
@@ -728,7 +735,14 @@ scale:
     scale->hsub = desc->log2_chroma_w;
     scale->vsub = desc->log2_chroma_h;
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    interlaced = scale->interlaced > 0 || (scale->interlaced < 0 && in->interlaced_frame);
+
+    /* progressive frames are scaled into buffers from the pool of the
+     * scaler, or reference the input if nothing needs to be converted */
+    if (interlaced)
+        out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    else
+        out = av_frame_alloc();
     if (!out) {
         av_frame_free(&in);
         return AVERROR(ENOMEM);
@@ -736,6 +750,7 @@ scale:
     *frame_out = out;
 
     av_frame_copy_props(out, in);
+    out->format = outlink->format;
     out->width  = outlink->w;
     out->height = outlink->h;
 
@@ -751,9 +766,6 @@ scale:
     else if (out->colorspace == AVCOL_SPC_RGB)
         out->colorspace = AVCOL_SPC_UNSPECIFIED;
 
-    if (scale->output_is_pal)
-        avpriv_set_systematic_pal2((uint32_t*)out->data[1], outlink->format == AV_PIX_FMT_PAL8 ? AV_PIX_FMT_BGR8 : outlink->format);
-
     in_range = in->color_range;
 
     if (   scale->in_color_matrix
@@ -802,24 +814,39 @@ scale:
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
-    if (scale->interlaced>0 || (scale->interlaced<0 && in->interlaced_frame)) {
+    if (interlaced) {
+        if (scale->output_is_pal)
+            set_systematic_pal(outlink, out);
         scale_slice(link, out, in, scale->isws[0], 0, (link->h+1)/2, 2, 0);
         scale_slice(link, out, in, scale->isws[1], 0,  link->h   /2, 2, 1);
-    } else if (scale->nb_slices) {
+    } else if (scale->nb_slices || scale->output_is_pal) {
         int i, slice_h, slice_start, slice_end = 0;
-        const int nb_slices = FFMIN(scale->nb_slices, link->h);
-        for (i = 0; i < nb_slices; i++) {
+        const int nb_slices = FFMIN(FFMAX(scale->nb_slices, 1), link->h);
+
+        ret = sws_frame_start(scale->sws, out, in);
+        /* the scaler writes PAL8 as BGR8, and the palette of a referenced
+         * input must be left alone */
+        if (ret >= 0 && scale->output_is_pal && out->data[1] != in->data[1]) {
+            out->format = outlink->format;
+            set_systematic_pal(outlink, out);
+        }
+        for (i = 0; i < nb_slices && ret >= 0; i++) {
             slice_start = slice_end;
             slice_end   = (link->h * (i+1)) / nb_slices;
             slice_h     = slice_end - slice_start;
-            scale_slice(link, out, in, scale->sws, slice_start, slice_h, 1, 0);
+            ret = sws_send_slice(scale->sws, slice_start, slice_h);
         }
+        if (ret >= 0)
+            ret = sws_receive_slice(scale->sws, 0, out->height);
+        sws_frame_end(scale->sws);
     } else {
-        scale_slice(link, out, in, scale->sws, 0, link->h, 1, 0);
+        ret = sws_scale_frame(scale->sws, out, in);
     }
 
     av_frame_free(&in);
-    return 0;
+    if (ret < 0)
+        av_frame_free(frame_out);
+    return ret;
 }
 
 static int filter_frame(AVFilterLink *link, AVFrame *in)
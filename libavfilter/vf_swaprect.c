@@ -39,7 +39,9 @@ typedef struct SwapRectContext {
     int pixsteps[4];
 
     const AVPixFmtDescriptor *desc;
-    uint8_t *temp;
+    uint8_t *temp;          ///< one line per thread
+    int temp_linesize;
+    int nb_threads;
 } SwapRectContext;
 
 #define OFFSET(x) offsetof(SwapRectContext, x)
@@ -76,21 +78,63 @@ static int query_formats(AVFilterContext *ctx)
 static const char *const var_names[] = {   "w",   "h",   "a",   "n",   "t",   "pos",   "sar",   "dar",        NULL };
 enum                                   { VAR_W, VAR_H, VAR_A, VAR_N, VAR_T, VAR_POS, VAR_SAR, VAR_DAR, VAR_VARS_NB };
 
+typedef struct ThreadData {
+    AVFrame *in;
+    int x1[4], y1[4];
+    int x2[4], y2[4];
+    int pw[4], ph[4];
+    int swap[4];
+} ThreadData;
+
+static int swap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SwapRectContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in;
+    uint8_t *temp = s->temp + jobnr * s->temp_linesize;
+    int y, p;
+
+    for (p = 0; p < s->nb_planes; p++) {
+        const int slice_start = (td->ph[p] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (td->ph[p] * (jobnr+1)) / nb_jobs;
+        const int linesize = in->linesize[p];
+        const int size = td->pw[p] * s->pixsteps[p];
+        uint8_t *src, *dst;
+
+        if (!td->swap[p])
+            continue;
+
+        src = in->data[p] + (td->y1[p] + slice_start) * linesize + td->x1[p] * s->pixsteps[p];
+        dst = in->data[p] + (td->y2[p] + slice_start) * linesize + td->x2[p] * s->pixsteps[p];
+
+        for (y = slice_start; y < slice_end; y++) {
+            memcpy(temp, src, size);
+            memmove(src, dst, size);
+            memcpy(dst, temp, size);
+            src += linesize;
+            dst += linesize;
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     SwapRectContext *s = ctx->priv;
     double var_values[VAR_VARS_NB];
-    int x1[4], y1[4];
-    int x2[4], y2[4];
+    ThreadData td = { .in = in };
+    int *x1 = td.x1, *y1 = td.y1;
+    int *x2 = td.x2, *y2 = td.y2;
     int aw[4], ah[4];
     int lw[4], lh[4];
-    int pw[4], ph[4];
+    int *pw = td.pw, *ph = td.ph;
     double dw,  dh;
     double dx1, dy1;
     double dx2, dy2;
-    int y, p, w, h, ret;
+    int p, w, h, ret, nb_jobs;
 
     var_values[VAR_W]   = inlink->w;
     var_values[VAR_H]   = inlink->h;
@@ -179,21 +223,18 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     y2[1] = y2[2] = AV_CEIL_RSHIFT(y2[0], s->desc->log2_chroma_h);
     y2[0] = y2[3] = y2[0];
 
+    nb_jobs = FFMAX(1, FFMIN(ph[0], s->nb_threads));
     for (p = 0; p < s->nb_planes; p++) {
-        if (ph[p] == ah[p] && pw[p] == aw[p]) {
-            uint8_t *src = in->data[p] + y1[p] * in->linesize[p] + x1[p] * s->pixsteps[p];
-            uint8_t *dst = in->data[p] + y2[p] * in->linesize[p] + x2[p] * s->pixsteps[p];
-
-            for (y = 0; y < ph[p]; y++) {
-                memcpy(s->temp, src, pw[p] * s->pixsteps[p]);
-                memmove(src, dst, pw[p] * s->pixsteps[p]);
-                memcpy(dst, s->temp, pw[p] * s->pixsteps[p]);
-                src += in->linesize[p];
-                dst += in->linesize[p];
-            }
-        }
+        td.swap[p] = ph[p] == ah[p] && pw[p] == aw[p];
+        /* the lines of overlapping rectangles must be swapped in order */
+        if (td.swap[p] &&
+            x1[p] < x2[p] + pw[p] && x2[p] < x1[p] + pw[p] &&
+            y1[p] < y2[p] + ph[p] && y2[p] < y1[p] + ph[p])
+            nb_jobs = 1;
     }
 
+    ctx->internal->execute(ctx, swap_slice, &td, NULL, nb_jobs);
+
     return ff_filter_frame(outlink, in);
 }
 
@@ -211,7 +252,10 @@ static int config_input(AVFilterLink *inlink)
     av_image_fill_max_pixsteps(s->pixsteps, NULL, s->desc);
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
 
-    s->temp = av_malloc_array(inlink->w, s->pixsteps[0]);
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->temp_linesize = inlink->w * s->pixsteps[0];
+    av_freep(&s->temp);
+    s->temp = av_malloc_array(s->nb_threads, s->temp_linesize);
     if (!s->temp)
         return AVERROR(ENOMEM);
 
@@ -252,6 +296,6 @@ AVFilter ff_vf_swaprect = {
     .uninit        = uninit,
     .inputs        = inputs,
     .outputs       = outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
     .process_command = ff_filter_process_command,
 };
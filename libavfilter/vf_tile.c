@@ -156,6 +156,61 @@ static void get_tile_pos(AVFilterContext *ctx, unsigned *x, unsigned *y, unsigne
     *y = tile->margin + (inlink->h + tile->padding) * ty;
 }
 
+typedef struct ThreadData {
+    AVFrame *out;
+    AVFrame *in;            ///< source of the copy, NULL to fill with the blank color
+    unsigned dst_x, dst_y;
+    unsigned src_x, src_y;
+    unsigned w, h;
+} ThreadData;
+
+/* The slices are aligned to the chroma subsampling relative to the top of the
+ * rectangle, so that together they cover the same chroma lines as a single
+ * copy or fill of the whole rectangle. */
+static int rectangle_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TileContext *tile = ctx->priv;
+    ThreadData *td    = arg;
+    const unsigned align   = 1 << tile->draw.vsub_max;
+    const unsigned nb_rows = td->h / align;
+    const unsigned start   = nb_rows * jobnr / nb_jobs * align;
+    const unsigned end     = jobnr == nb_jobs - 1 ? td->h : nb_rows * (jobnr + 1) / nb_jobs * align;
+
+    if (start >= end)
+        return 0;
+
+    if (td->in)
+        ff_copy_rectangle2(&tile->draw,
+                           td->out->data, td->out->linesize,
+                           td->in->data, td->in->linesize,
+                           td->dst_x, td->dst_y + start,
+                           td->src_x, td->src_y + start,
+                           td->w, end - start);
+    else
+        ff_fill_rectangle(&tile->draw, &tile->blank,
+                          td->out->data, td->out->linesize,
+                          td->dst_x, td->dst_y + start, td->w, end - start);
+    return 0;
+}
+
+static void process_rectangle(AVFilterContext *ctx, AVFrame *out, AVFrame *in,
+                              unsigned dst_x, unsigned dst_y,
+                              unsigned src_x, unsigned src_y,
+                              unsigned w, unsigned h)
+{
+    TileContext *tile = ctx->priv;
+    ThreadData td = {
+        .out   = out,   .in    = in,
+        .dst_x = dst_x, .dst_y = dst_y,
+        .src_x = src_x, .src_y = src_y,
+        .w     = w,     .h     = h,
+    };
+
+    ctx->internal->execute(ctx, rectangle_slice, &td, NULL,
+                           FFMAX(1, FFMIN(h >> tile->draw.vsub_max,
+                                          ff_filter_get_nb_threads(ctx))));
+}
+
 static void draw_blank_frame(AVFilterContext *ctx, AVFrame *out_buf)
 {
     TileContext *tile    = ctx->priv;
@@ -163,9 +218,7 @@ static void draw_blank_frame(AVFilterContext *ctx, AVFrame *out_buf)
     unsigned x0, y0;
 
     get_tile_pos(ctx, &x0, &y0, tile->current);
-    ff_fill_rectangle(&tile->draw, &tile->blank,
-                      out_buf->data, out_buf->linesize,
-                      x0, y0, inlink->w, inlink->h);
+    process_rectangle(ctx, out_buf, NULL, x0, y0, 0, 0, inlink->w, inlink->h);
     tile->current++;
 }
 
@@ -211,10 +264,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
 
         /* fill surface once for margin/padding */
         if (tile->margin || tile->padding || tile->init_padding)
-            ff_fill_rectangle(&tile->draw, &tile->blank,
-                              tile->out_ref->data,
-                              tile->out_ref->linesize,
-                              0, 0, outlink->w, outlink->h);
+            process_rectangle(ctx, tile->out_ref, NULL,
+                              0, 0, 0, 0, outlink->w, outlink->h);
         tile->init_padding = 0;
     }
 
@@ -224,19 +275,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
         for (i = tile->nb_frames - tile->overlap; i < tile->nb_frames; i++) {
             get_tile_pos(ctx, &x1, &y1, i);
             get_tile_pos(ctx, &x0, &y0, i - (tile->nb_frames - tile->overlap));
-            ff_copy_rectangle2(&tile->draw,
-                               tile->out_ref->data, tile->out_ref->linesize,
-                               tile->prev_out_ref->data, tile->prev_out_ref->linesize,
-                               x0, y0, x1, y1, inlink->w, inlink->h);
+            process_rectangle(ctx, tile->out_ref, tile->prev_out_ref,
+                              x0, y0, x1, y1, inlink->w, inlink->h);
 
         }
     }
 
     get_tile_pos(ctx, &x0, &y0, tile->current);
-    ff_copy_rectangle2(&tile->draw,
-                       tile->out_ref->data, tile->out_ref->linesize,
-                       picref->data, picref->linesize,
-                       x0, y0, 0, 0, inlink->w, inlink->h);
+    process_rectangle(ctx, tile->out_ref, picref,
+                      x0, y0, 0, 0, inlink->w, inlink->h);
 
     av_frame_free(&picref);
     if (++tile->current == tile->nb_frames)
@@ -295,4 +342,5 @@ AVFilter ff_vf_tile = {
     .inputs        = tile_inputs,
     .outputs       = tile_outputs,
     .priv_class    = &tile_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -28,6 +28,10 @@
 #include "libavutil/hwcontext.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#define FF_INTERNAL_FIELDS 1
+#include "framequeue.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -41,6 +45,49 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
     return ff_get_video_buffer(link->dst->outputs[0], w, h);
 }
 
+void ff_video_link_set_headroom(AVFilterLink *link, int left, int top,
+                                int right, int bottom)
+{
+    for (;;) {
+        AVFilterContext *src = link->src;
+        AVFilterLink *inlink;
+
+        link->headroom_left   = FFMAX(left,   0);
+        link->headroom_top    = FFMAX(top,    0);
+        link->headroom_right  = FFMAX(right,  0);
+        link->headroom_bottom = FFMAX(bottom, 0);
+
+        if (!(src->filter->flags_internal & FF_FILTER_FLAG_METADATA_ONLY) ||
+            src->nb_inputs != 1 || src->nb_outputs != 1)
+            break;
+        inlink = src->inputs[0];
+        if (!inlink || inlink->type != AVMEDIA_TYPE_VIDEO ||
+            inlink->w != link->w || inlink->h != link->h ||
+            inlink->format != link->format)
+            break;
+        link = inlink;
+    }
+}
+
+void ff_video_link_get_headroom(AVFilterLink *link, int *extra_width,
+                                int *extra_top, int *extra_bottom)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+
+    *extra_width = *extra_top = *extra_bottom = 0;
+    if (!desc || desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL |
+                                AV_PIX_FMT_FLAG_BITSTREAM))
+        return;
+
+    *extra_width  = link->headroom_left + link->headroom_right;
+    *extra_top    = link->headroom_top;
+    *extra_bottom = link->headroom_bottom;
+    /* The picture starts at the beginning of a line to keep its alignment,
+     * the left border then takes the end of the previous (chroma) line. */
+    if (link->headroom_left)
+        *extra_top += 1 << desc->log2_chroma_h;
+}
+
 AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
 {
     AVFrame *frame = NULL;
@@ -48,6 +95,7 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     int pool_height = 0;
     int pool_align = 0;
     enum AVPixelFormat pool_format = AV_PIX_FMT_NONE;
+    int extra_width, extra_top, extra_bottom;
 
     if (link->hw_frames_ctx &&
         ((AVHWFramesContext*)link->hw_frames_ctx->data)->format == link->format) {
@@ -64,6 +112,12 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
         return frame;
     }
 
+    ff_video_link_get_headroom(link, &extra_width, &extra_top, &extra_bottom);
+    if (w > INT_MAX - extra_width || h > INT_MAX - extra_top - extra_bottom)
+        return NULL;
+    w += extra_width;
+    h += extra_top + extra_bottom;
+
     if (!link->frame_pool) {
         link->frame_pool = ff_frame_pool_video_init(av_buffer_allocz, w, h,
                                                     link->format, BUFFER_ALIGN);
@@ -91,6 +145,18 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     if (!frame)
         return NULL;
 
+    if (extra_width || extra_top || extra_bottom) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+        int i;
+
+        for (i = 0; i < 4 && frame->data[i]; i++) {
+            int vsub = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+            frame->data[i] += (extra_top >> vsub) * frame->linesize[i];
+        }
+        frame->width  = w - extra_width;
+        frame->height = h - extra_top - extra_bottom;
+    }
+
     frame->sample_aspect_ratio = link->sample_aspect_ratio;
 
     return frame;
@@ -38,4 +38,32 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h);
  */
 AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h);
 
+/**
+ * Request room around the pictures sent on link, so that the destination
+ * filter can grow them in place (e.g. pad) instead of copying them.
+ *
+ * The buffers allocated by ff_default_get_video_buffer() for this link then
+ * have the requested space, and applications feeding a buffer source can
+ * query it with av_buffersrc_get_headroom(). Filters must still check each
+ * frame they get, as nothing guarantees it was allocated this way.
+ *
+ * The request also applies to the links upstream of filters flagged with
+ * FF_FILTER_FLAG_METADATA_ONLY, as far as they keep the size and format.
+ *
+ * Must be called from the config_props() callback of the destination input.
+ */
+void ff_video_link_set_headroom(AVFilterLink *link, int left, int top,
+                                int right, int bottom);
+
+/**
+ * Get the allocation geometry satisfying the headroom requested on link.
+ *
+ * @param extra_width  number of pixels to add to the width
+ * @param extra_top    number of lines to allocate above the picture, the
+ *                     picture starting at the first pixel of the next line
+ * @param extra_bottom number of lines to allocate below the picture
+ */
+void ff_video_link_get_headroom(AVFilterLink *link, int *extra_width,
+                                int *extra_top, int *extra_bottom);
+
 #endif /* AVFILTER_VIDEO_H */
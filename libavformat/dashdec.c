@@ -27,10 +27,12 @@
 #include "internal.h"
 #include "avio_internal.h"
 #include "dash.h"
+#include "prefetch.h"
 
 #define INITIAL_BUFFER_SIZE 32768
 #define MAX_BPRINT_READ_SIZE (UINT_MAX - 1)
 #define DEFAULT_MANIFEST_SIZE 8 * 1024
+#define MAX_PREFETCH 64
 
 struct fragment {
     int64_t url_offset;
@@ -69,6 +71,8 @@ struct timeline {
     int64_t duration;
 };
 
+struct prefetch;
+
 /*
  * Each playlist has its own demuxer. If it is currently active,
  * it has an opened AVIOContext too, and potentially an AVPacket
@@ -78,6 +82,11 @@ struct representation {
     char *url_template;
     AVIOContext pb;
     AVIOContext *input;
+    /* Upcoming fragments being downloaded in the background, and the one
+     * currently read instead of input, if any. */
+    struct prefetch *prefetch;
+    int n_prefetch;
+    struct prefetch *input_prefetch;
     AVFormatContext *parent;
     AVFormatContext *ctx;
     int stream_index;
@@ -157,8 +166,14 @@ typedef struct DASHContext {
     int is_init_section_common_audio;
     int is_init_section_common_subtitle;
 
+    int prefetch;
+    int prefetch_size;
+    FFPrefetchGroup prefetch_group;
 } DASHContext;
 
+static void prefetch_free(struct representation *pls);
+static void prefetch_reset_all(struct representation *pls);
+
 static int ishttp(char *url)
 {
     const char *proto_name = avio_find_protocol_name(url);
@@ -353,6 +368,7 @@ static void free_representation(struct representation *pls)
     free_fragment(&pls->init_section);
     av_freep(&pls->init_sec_buf);
     av_freep(&pls->pb.buffer);
+    prefetch_free(pls);
     ff_format_io_close(pls->parent, &pls->input);
     if (pls->ctx) {
         pls->ctx->pb = NULL;
@@ -399,7 +415,8 @@ static void free_subtitle_list(DASHContext *c)
 }
 
 static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http)
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http,
+                    const AVIOInterruptCB *int_cb)
 {
     DASHContext *c = s->priv_data;
     AVDictionary *tmp = NULL;
@@ -441,7 +458,7 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     av_freep(pb);
     av_dict_copy(&tmp, *opts, 0);
     av_dict_copy(&tmp, opts2, 0);
-    ret = avio_open2(pb, url, AVIO_FLAG_READ, c->interrupt_callback, &tmp);
+    ret = avio_open2(pb, url, AVIO_FLAG_READ, int_cb, &tmp);
     if (ret >= 0) {
         // update cookies on http response with setcookies.
         char *new_cookies = NULL;
@@ -1582,29 +1599,70 @@ finish:
     return ret;
 }
 
+static struct fragment *copy_fragment(const struct fragment *seg_ptr)
+{
+    struct fragment *seg = av_mallocz(sizeof(struct fragment));
+    if (!seg) {
+        return NULL;
+    }
+    seg->url = av_strdup(seg_ptr->url);
+    if (!seg->url) {
+        av_free(seg);
+        return NULL;
+    }
+    seg->size = seg_ptr->size;
+    seg->url_offset = seg_ptr->url_offset;
+    return seg;
+}
+
+/* Build the fragment with the given sequence number from the url template. */
+static struct fragment *get_template_fragment(struct representation *pls, int64_t seq_no)
+{
+    DASHContext *c = pls->parent->priv_data;
+    struct fragment *seg;
+    char *tmpfilename;
+
+    if (!pls->url_template) {
+        av_log(pls->parent, AV_LOG_ERROR, "Cannot get fragment, missing template URL\n");
+        return NULL;
+    }
+    seg = av_mallocz(sizeof(struct fragment));
+    if (!seg) {
+        return NULL;
+    }
+    tmpfilename = av_mallocz(c->max_url_size);
+    if (!tmpfilename) {
+        av_free(seg);
+        return NULL;
+    }
+    ff_dash_fill_tmpl_params(tmpfilename, c->max_url_size, pls->url_template, 0, seq_no, 0, get_segment_start_time_based_on_timeline(pls, seq_no));
+    seg->url = av_strireplace(pls->url_template, pls->url_template, tmpfilename);
+    if (!seg->url) {
+        av_log(pls->parent, AV_LOG_WARNING, "Unable to resolve template url '%s', try to use origin template\n", pls->url_template);
+        seg->url = av_strdup(pls->url_template);
+        if (!seg->url) {
+            av_log(pls->parent, AV_LOG_ERROR, "Cannot resolve template url '%s'\n", pls->url_template);
+            av_free(tmpfilename);
+            av_free(seg);
+            return NULL;
+        }
+    }
+    av_free(tmpfilename);
+    seg->size = -1;
+
+    return seg;
+}
+
 static struct fragment *get_current_fragment(struct representation *pls)
 {
     int64_t min_seq_no = 0;
     int64_t max_seq_no = 0;
-    struct fragment *seg = NULL;
-    struct fragment *seg_ptr = NULL;
+    int use_template = 0;
     DASHContext *c = pls->parent->priv_data;
 
     while (( !ff_check_interrupt(c->interrupt_callback)&& pls->n_fragments > 0)) {
         if (pls->cur_seq_no < pls->n_fragments) {
-            seg_ptr = pls->fragments[pls->cur_seq_no];
-            seg = av_mallocz(sizeof(struct fragment));
-            if (!seg) {
-                return NULL;
-            }
-            seg->url = av_strdup(seg_ptr->url);
-            if (!seg->url) {
-                av_free(seg);
-                return NULL;
-            }
-            seg->size = seg_ptr->size;
-            seg->url_offset = seg_ptr->url_offset;
-            return seg;
+            return copy_fragment(pls->fragments[pls->cur_seq_no]);
         } else if (c->is_live) {
             refresh_manifest(pls->parent);
         } else {
@@ -1624,45 +1682,193 @@ static struct fragment *get_current_fragment(struct representation *pls)
         } else if (pls->cur_seq_no > max_seq_no) {
             av_log(pls->parent, AV_LOG_VERBOSE, "new fragment: min[%"PRId64"] max[%"PRId64"]\n", min_seq_no, max_seq_no);
         }
-        seg = av_mallocz(sizeof(struct fragment));
-        if (!seg) {
-            return NULL;
-        }
+        use_template = 1;
     } else if (pls->cur_seq_no <= pls->last_seq_no) {
-        seg = av_mallocz(sizeof(struct fragment));
-        if (!seg) {
-            return NULL;
+        use_template = 1;
+    }
+
+    return use_template ? get_template_fragment(pls, pls->cur_seq_no) : NULL;
+}
+
+/*
+ * A fragment downloaded in the background. All the downloads of a
+ * DASHContext share the prefetch_size budget. A slot is unused if the
+ * seq_no of its download is negative.
+ */
+struct prefetch {
+    FFPrefetch dl;
+    struct fragment *seg;
+};
+
+static int prefetch_open(AVFormatContext *s, FFPrefetch *p, AVIOContext **pb)
+{
+    return open_url(s, pb, p->url, &p->opts, p->seg_opts, NULL,
+                    &p->interrupt_callback);
+}
+
+/* Stop the download of a slot, if any, and mark it as unused. */
+static void prefetch_reset(struct prefetch *p)
+{
+    ff_prefetch_reset(&p->dl);
+    free_fragment(&p->seg);
+}
+
+static void prefetch_reset_all(struct representation *pls)
+{
+    int i;
+
+    for (i = 0; i < pls->n_prefetch; i++)
+        prefetch_reset(&pls->prefetch[i]);
+    pls->input_prefetch = NULL;
+}
+
+static void prefetch_free(struct representation *pls)
+{
+    prefetch_reset_all(pls);
+    av_freep(&pls->prefetch);
+    pls->n_prefetch = 0;
+}
+
+/*
+ * The fragment with the given sequence number, or NULL if it is not known to
+ * be available yet.
+ */
+static struct fragment *get_prefetch_fragment(struct representation *pls, int64_t seq_no)
+{
+    DASHContext *c = pls->parent->priv_data;
+
+    if (pls->n_fragments)
+        return seq_no < pls->n_fragments ? copy_fragment(pls->fragments[seq_no]) : NULL;
+    if (!pls->url_template ||
+        seq_no > (c->is_live ? calc_max_seg_no(pls, c) : pls->last_seq_no))
+        return NULL;
+    return get_template_fragment(pls, seq_no);
+}
+
+static int is_same_fragment(const struct fragment *a, const struct fragment *b)
+{
+    return a && b && !strcmp(a->url, b->url) &&
+           a->url_offset == b->url_offset && a->size == b->size;
+}
+
+/*
+ * Cancel the downloads which are not needed anymore, e.g. after a seek or
+ * after a manifest refresh changed their fragments.
+ */
+static void prefetch_check(DASHContext *c, struct representation *pls)
+{
+    int i;
+
+    for (i = 0; i < pls->n_prefetch; i++) {
+        struct prefetch *p = &pls->prefetch[i];
+        struct fragment *seg;
+
+        if (p->dl.seq_no < 0 || p == pls->input_prefetch)
+            continue;
+        if (p->dl.seq_no < pls->cur_seq_no ||
+            p->dl.seq_no > pls->cur_seq_no + c->prefetch) {
+            prefetch_reset(p);
+            continue;
         }
+        seg = get_prefetch_fragment(pls, p->dl.seq_no);
+        if (!is_same_fragment(seg, p->seg))
+            prefetch_reset(p);
+        free_fragment(&seg);
     }
-    if (seg) {
-        char *tmpfilename;
-        if (!pls->url_template) {
-            av_log(pls->parent, AV_LOG_ERROR, "Cannot get fragment, missing template URL\n");
-            av_free(seg);
-            return NULL;
+}
+
+/*
+ * Start downloading the fragments following the current one, up to the
+ * prefetch depth. One slot per prefetched fragment is allocated, plus the
+ * one of the fragment being read.
+ */
+static int prefetch_start(DASHContext *c, struct representation *pls)
+{
+    struct prefetch *p = NULL;
+    int64_t seq_no;
+    int i, ret;
+
+    if (!c->prefetch)
+        return 0;
+    if (!pls->prefetch) {
+        pls->prefetch = av_calloc(c->prefetch + 1, sizeof(*pls->prefetch));
+        if (!pls->prefetch)
+            return AVERROR(ENOMEM);
+        for (i = 0; i <= c->prefetch; i++)
+            ff_prefetch_init(&pls->prefetch[i].dl, &c->prefetch_group);
+        pls->n_prefetch = c->prefetch + 1;
+    }
+    prefetch_check(c, pls);
+
+    for (seq_no = pls->cur_seq_no + 1; seq_no <= pls->cur_seq_no + c->prefetch; seq_no++) {
+        p = NULL;
+        for (i = 0; i < pls->n_prefetch; i++) {
+            struct prefetch *slot = &pls->prefetch[i];
+            if (slot->dl.seq_no == seq_no)
+                break;
+            if (!p && slot->dl.seq_no < 0 && slot != pls->input_prefetch)
+                p = slot;
+        }
+        if (i < pls->n_prefetch)
+            continue;
+        if (!p)
+            break;
+
+        p->seg = get_prefetch_fragment(pls, seq_no);
+        if (!p->seg)
+            break;
+        p->dl.url  = av_mallocz(c->max_url_size);
+        p->dl.size = p->seg->size;
+        if (!p->dl.url || av_dict_copy(&p->dl.opts, c->avio_opts, 0) < 0) {
+            prefetch_reset(p);
+            return AVERROR(ENOMEM);
         }
-        tmpfilename = av_mallocz(c->max_url_size);
-        if (!tmpfilename) {
-            av_free(seg);
-            return NULL;
+        ff_make_absolute_url(p->dl.url, c->max_url_size, c->base_url, p->seg->url);
+        if (p->seg->size >= 0) {
+            av_dict_set_int(&p->dl.seg_opts, "offset", p->seg->url_offset, 0);
+            av_dict_set_int(&p->dl.seg_opts, "end_offset", p->seg->url_offset + p->seg->size, 0);
         }
-        ff_dash_fill_tmpl_params(tmpfilename, c->max_url_size, pls->url_template, 0, pls->cur_seq_no, 0, get_segment_start_time_based_on_timeline(pls, pls->cur_seq_no));
-        seg->url = av_strireplace(pls->url_template, pls->url_template, tmpfilename);
-        if (!seg->url) {
-            av_log(pls->parent, AV_LOG_WARNING, "Unable to resolve template url '%s', try to use origin template\n", pls->url_template);
-            seg->url = av_strdup(pls->url_template);
-            if (!seg->url) {
-                av_log(pls->parent, AV_LOG_ERROR, "Cannot resolve template url '%s'\n", pls->url_template);
-                av_free(tmpfilename);
-                av_free(seg);
-                return NULL;
-            }
+
+        av_log(pls->parent, AV_LOG_VERBOSE, "DASH prefetch of fragment %"PRId64" for url '%s', offset %"PRId64"\n",
+               seq_no, p->dl.url, p->seg->url_offset);
+
+        if ((ret = ff_prefetch_start(&p->dl, seq_no)) < 0) {
+            free_fragment(&p->seg);
+            return ret;
         }
-        av_free(tmpfilename);
-        seg->size = -1;
     }
+    return 0;
+}
 
-    return seg;
+/*
+ * Return the slot downloading the current fragment of the representation,
+ * or NULL if it is not being prefetched or its download failed before
+ * returning any data.
+ */
+static struct prefetch *prefetch_take(DASHContext *c, struct representation *pls,
+                                      struct fragment *seg)
+{
+    struct prefetch *p = NULL;
+    AVDictionaryEntry *cookies;
+    int i;
+
+    for (i = 0; i < pls->n_prefetch; i++) {
+        if (pls->prefetch[i].dl.seq_no == pls->cur_seq_no &&
+            is_same_fragment(pls->prefetch[i].seg, seg))
+            p = &pls->prefetch[i];
+    }
+    if (!p)
+        return NULL;
+
+    if (ff_prefetch_wait(&p->dl) < 0) {
+        prefetch_reset(p);
+        return NULL;
+    }
+
+    /* the download updated its own copy of the cookies */
+    if ((cookies = av_dict_get(p->dl.opts, "cookies", NULL, 0)))
+        av_dict_set(&c->avio_opts, "cookies", cookies->value, 0);
+    return p;
 }
 
 static int read_from_url(struct representation *pls, struct fragment *seg,
@@ -1674,7 +1880,10 @@ static int read_from_url(struct representation *pls, struct fragment *seg,
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, pls->cur_seg_size - pls->cur_seg_offset);
 
-    ret = avio_read(pls->input, buf, buf_size);
+    if (pls->input_prefetch)
+        ret = ff_prefetch_read(&pls->input_prefetch->dl, buf, buf_size);
+    else
+        ret = avio_read(pls->input, buf, buf_size);
     if (ret > 0)
         pls->cur_seg_offset += ret;
 
@@ -1703,7 +1912,8 @@ static int open_input(DASHContext *c, struct representation *pls, struct fragmen
     ff_make_absolute_url(url, c->max_url_size, c->base_url, seg->url);
     av_log(pls->parent, AV_LOG_VERBOSE, "DASH request for url '%s', offset %"PRId64"\n",
            url, seg->url_offset);
-    ret = open_url(pls->parent, &pls->input, url, &c->avio_opts, opts, NULL);
+    ret = open_url(pls->parent, &pls->input, url, &c->avio_opts, opts, NULL,
+                   c->interrupt_callback);
 
 cleanup:
     av_free(url);
@@ -1762,7 +1972,18 @@ static int update_init_section(struct representation *pls)
 static int64_t seek_data(void *opaque, int64_t offset, int whence)
 {
     struct representation *v = opaque;
+    DASHContext *c = v->parent->priv_data;
+    int ret;
+
     if (v->n_fragments && !v->init_sec_data_len) {
+        /* prefetched data can only be read in order, so continue the
+         * fragment from a connection of its own */
+        if (v->input_prefetch) {
+            prefetch_reset(v->input_prefetch);
+            v->input_prefetch = NULL;
+            if ((ret = open_input(c, v, v->cur_seg)) < 0)
+                return ret;
+        }
         return avio_seek(v->input, offset, whence);
     }
 
@@ -1776,7 +1997,7 @@ static int read_data(void *opaque, uint8_t *buf, int buf_size)
     DASHContext *c = v->parent->priv_data;
 
 restart:
-    if (!v->input) {
+    if (!v->input && !v->input_prefetch) {
         free_fragment(&v->cur_seg);
         v->cur_seg = get_current_fragment(v);
         if (!v->cur_seg) {
@@ -1789,7 +2010,18 @@ restart:
         if (ret)
             goto end;
 
-        ret = open_input(c, v, v->cur_seg);
+        /* start the following downloads before waiting for this one */
+        ret = prefetch_start(c, v);
+        if (ret < 0)
+            goto end;
+
+        if ((v->input_prefetch = prefetch_take(c, v, v->cur_seg))) {
+            v->cur_seg_offset = 0;
+            v->cur_seg_size = v->cur_seg->size;
+            ret = 0;
+        } else {
+            ret = open_input(c, v, v->cur_seg);
+        }
         if (ret < 0) {
             if (ff_check_interrupt(c->interrupt_callback)) {
                 ret = AVERROR_EXIT;
@@ -2058,6 +2290,15 @@ static int dash_read_header(AVFormatContext *s)
 
     c->interrupt_callback = &s->interrupt_callback;
 
+    if (!HAVE_THREADS && c->prefetch) {
+        av_log(s, AV_LOG_WARNING, "Fragment prefetching requires threads, disabling it\n");
+        c->prefetch = 0;
+    }
+    if (c->prefetch &&
+        (ret = ff_prefetch_group_init(&c->prefetch_group, s, prefetch_open,
+                                      c->prefetch_size, INT64_MAX)) < 0)
+        return ret;
+
     if ((ret = save_avio_options(s)) < 0)
         goto fail;
 
@@ -2189,6 +2430,7 @@ static void recheck_discard_flags(AVFormatContext *s, struct representation **p,
             av_log(s, AV_LOG_INFO, "Now receiving stream_index %d\n", pls->stream_index);
         } else if (!needed && pls->ctx) {
             close_demux_for_component(pls);
+            prefetch_reset_all(pls);
             ff_format_io_close(pls->parent, &pls->input);
             av_log(s, AV_LOG_INFO, "No longer receiving stream_index %d\n", pls->stream_index);
         }
@@ -2250,6 +2492,10 @@ static int dash_read_packet(AVFormatContext *s, AVPacket *pkt)
         if (cur->is_restart_needed) {
             cur->cur_seg_offset = 0;
             cur->init_sec_buf_read_offset = 0;
+            if (cur->input_prefetch) {
+                prefetch_reset(cur->input_prefetch);
+                cur->input_prefetch = NULL;
+            }
             ff_format_io_close(cur->parent, &cur->input);
             ret = reopen_demux_for_component(s, cur);
             cur->is_restart_needed = 0;
@@ -2266,6 +2512,7 @@ static int dash_close(AVFormatContext *s)
     free_subtitle_list(c);
     av_dict_free(&c->avio_opts);
     av_freep(&c->base_url);
+    ff_prefetch_group_uninit(&c->prefetch_group);
     return 0;
 }
 
@@ -2289,6 +2536,7 @@ static int dash_seek(AVFormatContext *s, struct representation *pls, int64_t see
         return av_seek_frame(pls->ctx, -1, seek_pos_msec * 1000, flags);
     }
 
+    prefetch_reset_all(pls);
     ff_format_io_close(pls->parent, &pls->input);
 
     // find the nearest fragment
@@ -2387,6 +2635,10 @@ static const AVOption dash_options[] = {
         OFFSET(allowed_extensions), AV_OPT_TYPE_STRING,
         {.str = "aac,m4a,m4s,m4v,mov,mp4,webm,ts"},
         INT_MIN, INT_MAX, FLAGS},
+    {"prefetch", "Number of upcoming fragments to download in advance for each representation",
+        OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0}, 0, MAX_PREFETCH, FLAGS},
+    {"prefetch_size", "Maximum number of bytes buffered by the downloads of all representations",
+        OFFSET(prefetch_size), AV_OPT_TYPE_INT, {.i64 = 16 << 20}, INITIAL_BUFFER_SIZE, INT_MAX, FLAGS},
     {NULL}
 };
 
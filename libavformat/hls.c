@@ -38,8 +38,10 @@
 #include "internal.h"
 #include "avio_internal.h"
 #include "id3v2.h"
+#include "prefetch.h"
 
 #define INITIAL_BUFFER_SIZE 32768
+#define MAX_PREFETCH 64
 
 #define MAX_FIELD_LEN 64
 #define MAX_CHARACTERISTICS_LEN 512
@@ -98,6 +100,11 @@ struct playlist {
     int input_read_done;
     AVIOContext *input_next;
     int input_next_requested;
+    /* Upcoming segments being downloaded in the background, and the one
+     * currently read instead of input, if any. */
+    FFPrefetch *prefetch;
+    int n_prefetch;
+    FFPrefetch *input_prefetch;
     AVFormatContext *parent;
     int index;
     AVFormatContext *ctx;
@@ -212,9 +219,15 @@ typedef struct HLSContext {
     int http_persistent;
     int http_multiple;
     int http_seekable;
+    int prefetch;
+    int prefetch_size;
+    FFPrefetchGroup prefetch_group;
     AVIOContext *playlist_pb;
 } HLSContext;
 
+static void prefetch_free(struct playlist *pls);
+static void prefetch_reset_all(struct playlist *pls);
+
 static void free_segment_dynarray(struct segment **segments, int n_segments)
 {
     int i;
@@ -258,6 +271,7 @@ static void free_playlist_list(HLSContext *c)
         av_freep(&pls->init_sec_buf);
         av_packet_free(&pls->pkt);
         av_freep(&pls->pb.buffer);
+        prefetch_free(pls);
         ff_format_io_close(c->ctx, &pls->input);
         pls->input_read_done = 0;
         ff_format_io_close(c->ctx, &pls->input_next);
@@ -622,7 +636,8 @@ static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
 }
 
 static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out,
+                    const AVIOInterruptCB *int_cb)
 {
     HLSContext *c = s->priv_data;
     AVDictionary *tmp = NULL;
@@ -684,10 +699,10 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
                     url, av_err2str(ret));
             av_dict_copy(&tmp, *opts, 0);
             av_dict_copy(&tmp, opts2, 0);
-            ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+            ret = ff_format_io_open_cb(s, pb, url, AVIO_FLAG_READ, int_cb, &tmp);
         }
     } else {
-        ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+        ret = ff_format_io_open_cb(s, pb, url, AVIO_FLAG_READ, int_cb, &tmp);
     }
     if (ret >= 0) {
         // update cookies on http response with setcookies.
@@ -1018,6 +1033,168 @@ static struct segment *next_segment(struct playlist *pls)
     return pls->segments[n];
 }
 
+static int prefetch_open(AVFormatContext *s, FFPrefetch *p, AVIOContext **pb)
+{
+    int is_http = 0;
+    int ret;
+
+    ret = open_url(s, pb, p->url, &p->opts, p->seg_opts, &is_http,
+                   &p->interrupt_callback);
+    if (ret >= 0 && !is_http && p->url_offset) {
+        int64_t seekret = avio_seek(*pb, p->url_offset, SEEK_SET);
+        if (seekret < 0)
+            ret = seekret;
+    }
+    return ret;
+}
+
+static void prefetch_reset_all(struct playlist *pls)
+{
+    int i;
+
+    for (i = 0; i < pls->n_prefetch; i++)
+        ff_prefetch_reset(&pls->prefetch[i]);
+    pls->input_prefetch = NULL;
+}
+
+static void prefetch_free(struct playlist *pls)
+{
+    prefetch_reset_all(pls);
+    av_freep(&pls->prefetch);
+    pls->n_prefetch = 0;
+}
+
+/*
+ * One slot per prefetched segment, plus the one of the segment being read.
+ * The slots only allocate their buffer once their download returns data.
+ */
+static int prefetch_alloc(HLSContext *c, struct playlist *pls)
+{
+    int i;
+
+    pls->prefetch = av_calloc(c->prefetch + 1, sizeof(*pls->prefetch));
+    if (!pls->prefetch)
+        return AVERROR(ENOMEM);
+    for (i = 0; i <= c->prefetch; i++)
+        ff_prefetch_init(&pls->prefetch[i], &c->prefetch_group);
+    pls->n_prefetch = c->prefetch + 1;
+    return 0;
+}
+
+/*
+ * Cancel the downloads which do not match the playlist anymore, e.g. after
+ * a reload removed the segments or changed their url.
+ */
+static void prefetch_check(struct playlist *pls)
+{
+    int i;
+
+    for (i = 0; i < pls->n_prefetch; i++) {
+        FFPrefetch *p = &pls->prefetch[i];
+        int64_t n = p->seq_no - pls->start_seq_no;
+
+        if (p->seq_no < 0 || p == pls->input_prefetch)
+            continue;
+        if (p->seq_no < pls->cur_seq_no || n < 0 || n >= pls->n_segments ||
+            strcmp(p->url, pls->segments[n]->url))
+            ff_prefetch_reset(p);
+    }
+}
+
+/*
+ * Start downloading the segments following the current one, up to the
+ * prefetch depth, and cancel the downloads which are not needed anymore.
+ * Encrypted segments are not prefetched, since their keys are fetched and
+ * cached by the playlist as they are opened.
+ */
+static int prefetch_start(HLSContext *c, struct playlist *pls)
+{
+    FFPrefetch *p;
+    int64_t seq_no;
+    int i, ret;
+
+    if (!c->prefetch)
+        return 0;
+    if (!pls->prefetch && (ret = prefetch_alloc(c, pls)) < 0)
+        return ret;
+    prefetch_check(pls);
+
+    for (seq_no = pls->cur_seq_no + 1;
+         seq_no <= pls->cur_seq_no + c->prefetch &&
+         seq_no <  pls->start_seq_no + pls->n_segments; seq_no++) {
+        struct segment *seg = pls->segments[seq_no - pls->start_seq_no];
+
+        p = NULL;
+
+        if (seg->key_type != KEY_NONE)
+            break;
+
+        for (i = 0; i < pls->n_prefetch; i++) {
+            FFPrefetch *slot = &pls->prefetch[i];
+            if (slot->seq_no == seq_no)
+                break;
+            if (!p && slot->seq_no < 0 && slot != pls->input_prefetch)
+                p = slot;
+        }
+        if (i < pls->n_prefetch)
+            continue;
+        if (!p)
+            break;
+
+        p->url        = av_strdup(seg->url);
+        p->url_offset = seg->url_offset;
+        p->size       = seg->size;
+        if (!p->url || av_dict_copy(&p->opts, c->avio_opts, 0) < 0) {
+            ff_prefetch_reset(p);
+            return AVERROR(ENOMEM);
+        }
+        if (c->http_persistent)
+            av_dict_set(&p->seg_opts, "multiple_requests", "1", 0);
+        if (seg->size >= 0) {
+            av_dict_set_int(&p->seg_opts, "offset", seg->url_offset, 0);
+            av_dict_set_int(&p->seg_opts, "end_offset", seg->url_offset + seg->size, 0);
+        }
+
+        av_log(pls->parent, AV_LOG_VERBOSE, "HLS prefetch of segment %"PRId64" for url '%s', playlist %d\n",
+               seq_no, seg->url, pls->index);
+
+        if ((ret = ff_prefetch_start(p, seq_no)) < 0)
+            return ret;
+    }
+    return 0;
+}
+
+/*
+ * Return the slot downloading the given segment, which is the current
+ * segment of the playlist, or NULL if it is not being prefetched or its
+ * download failed before returning any data.
+ */
+static FFPrefetch *prefetch_take(HLSContext *c, struct playlist *pls,
+                                 struct segment *seg)
+{
+    FFPrefetch *p = NULL;
+    AVDictionaryEntry *cookies;
+    int i;
+
+    for (i = 0; i < pls->n_prefetch; i++) {
+        if (pls->prefetch[i].seq_no == pls->cur_seq_no &&
+            !strcmp(pls->prefetch[i].url, seg->url))
+            p = &pls->prefetch[i];
+    }
+    if (!p)
+        return NULL;
+
+    if (ff_prefetch_wait(p) < 0) {
+        ff_prefetch_reset(p);
+        return NULL;
+    }
+
+    /* the download updated its own copy of the cookies */
+    if ((cookies = av_dict_get(p->opts, "cookies", NULL, 0)))
+        av_dict_set(&c->avio_opts, "cookies", cookies->value, 0);
+    return p;
+}
+
 static int read_from_url(struct playlist *pls, struct segment *seg,
                          uint8_t *buf, int buf_size)
 {
@@ -1027,7 +1204,10 @@ static int read_from_url(struct playlist *pls, struct segment *seg,
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, seg->size - pls->cur_seg_offset);
 
-    ret = avio_read(pls->input, buf, buf_size);
+    if (pls->input_prefetch)
+        ret = ff_prefetch_read(pls->input_prefetch, buf, buf_size);
+    else
+        ret = avio_read(pls->input, buf, buf_size);
     if (ret > 0)
         pls->cur_seg_offset += ret;
 
@@ -1252,12 +1432,14 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
            seg->url, seg->url_offset, pls->index);
 
     if (seg->key_type == KEY_NONE) {
-        ret = open_url(pls->parent, in, seg->url, &c->avio_opts, opts, &is_http);
+        ret = open_url(pls->parent, in, seg->url, &c->avio_opts, opts, &is_http,
+                       c->interrupt_callback);
     } else if (seg->key_type == KEY_AES_128) {
         char iv[33], key[33], url[MAX_URL_SIZE];
         if (strcmp(seg->key, pls->key_url)) {
             AVIOContext *pb = NULL;
-            if (open_url(pls->parent, &pb, seg->key, &c->avio_opts, opts, NULL) == 0) {
+            if (open_url(pls->parent, &pb, seg->key, &c->avio_opts, opts, NULL,
+                         c->interrupt_callback) == 0) {
                 ret = avio_read(pb, pls->key, sizeof(pls->key));
                 if (ret != sizeof(pls->key)) {
                     av_log(pls->parent, AV_LOG_ERROR, "Unable to read key file %s\n",
@@ -1281,7 +1463,8 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
         av_dict_set(&opts, "key", key, 0);
         av_dict_set(&opts, "iv", iv, 0);
 
-        ret = open_url(pls->parent, in, url, &c->avio_opts, opts, &is_http);
+        ret = open_url(pls->parent, in, url, &c->avio_opts, opts, &is_http,
+                       c->interrupt_callback);
         if (ret < 0) {
             goto cleanup;
         }
@@ -1442,7 +1625,8 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if (!v->input_prefetch &&
+        (!v->input || (c->http_persistent && v->input_read_done))) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1452,6 +1636,7 @@ restart:
         if (!v->needed) {
             av_log(v->parent, AV_LOG_INFO, "No longer receiving playlist %d ('%s')\n",
                    v->index, v->url);
+            prefetch_reset_all(v);
             return AVERROR_EOF;
         }
 
@@ -1471,6 +1656,7 @@ reload:
                            v->index);
                 return ret;
             }
+            prefetch_check(v);
             /* If we need to reload the playlist again below (if
              * there's still no more segments), switch to a reload
              * interval of half the target duration. */
@@ -1513,7 +1699,18 @@ reload:
         if (ret)
             return ret;
 
-        if (c->http_multiple == 1 && v->input_next_requested) {
+        /* start the following downloads before waiting for this one */
+        ret = prefetch_start(c, v);
+        if (ret < 0)
+            return ret;
+
+        if ((v->input_prefetch = prefetch_take(c, v, seg))) {
+            /* a persistent connection stays idle until the next request */
+            if (v->input)
+                v->input_read_done = 1;
+            v->cur_seg_offset = 0;
+            ret = 0;
+        } else if (c->http_multiple == 1 && v->input_next_requested) {
             FFSWAP(AVIOContext *, v->input, v->input_next);
             v->cur_seg_offset = 0;
             v->input_next_requested = 0;
@@ -1533,7 +1730,7 @@ reload:
         just_opened = 1;
     }
 
-    if (c->http_multiple == -1) {
+    if (c->http_multiple == -1 && v->input) {
         uint8_t *http_version_opt = NULL;
         int r = av_opt_get(v->input, "http_version", AV_OPT_SEARCH_CHILDREN, &http_version_opt);
         if (r >= 0) {
@@ -1543,7 +1740,7 @@ reload:
     }
 
     seg = next_segment(v);
-    if (c->http_multiple == 1 && !v->input_next_requested &&
+    if (c->http_multiple == 1 && !c->prefetch && !v->input_next_requested &&
         seg && seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         ret = open_input(c, v, seg, &v->input_next);
         if (ret < 0) {
@@ -1576,7 +1773,10 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->input_prefetch) {
+        ff_prefetch_reset(v->input_prefetch);
+        v->input_prefetch = NULL;
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
@@ -1854,6 +2054,7 @@ static int hls_close(AVFormatContext *s)
     free_playlist_list(c);
     free_variant_list(c);
     free_rendition_list(c);
+    ff_prefetch_group_uninit(&c->prefetch_group);
 
     av_dict_free(&c->avio_opts);
     ff_format_io_close(c->ctx, &c->playlist_pb);
@@ -1877,6 +2078,15 @@ static int hls_read_header(AVFormatContext *s)
     if ((ret = save_avio_options(s)) < 0)
         goto fail;
 
+    if (!HAVE_THREADS && c->prefetch) {
+        av_log(s, AV_LOG_WARNING, "Segment prefetching requires threads, disabling it\n");
+        c->prefetch = 0;
+    }
+    if (c->prefetch &&
+        (ret = ff_prefetch_group_init(&c->prefetch_group, s, prefetch_open,
+                                      INT64_MAX, c->prefetch_size)) < 0)
+        goto fail;
+
     /* XXX: Some HLS servers don't like being sent the range header,
        in this case, need to  setting http_seekable = 0 to disable
        the range header */
@@ -2100,6 +2310,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             }
             av_log(s, AV_LOG_INFO, "Now receiving playlist %d, segment %"PRId64"\n", i, pls->cur_seq_no);
         } else if (first && !cur_needed && pls->needed) {
+            prefetch_reset_all(pls);
             ff_format_io_close(pls->parent, &pls->input);
             pls->input_read_done = 0;
             ff_format_io_close(pls->parent, &pls->input_next);
@@ -2340,6 +2551,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
     for (i = 0; i < c->n_playlists; i++) {
         /* Reset reading */
         struct playlist *pls = c->playlists[i];
+        prefetch_reset_all(pls);
         ff_format_io_close(pls->parent, &pls->input);
         pls->input_read_done = 0;
         ff_format_io_close(pls->parent, &pls->input_next);
@@ -2405,6 +2617,10 @@ static const AVOption hls_options[] = {
         OFFSET(http_multiple), AV_OPT_TYPE_BOOL, {.i64 = -1}, -1, 1, FLAGS},
     {"http_seekable", "Use HTTP partial requests, 0 = disable, 1 = enable, -1 = auto",
         OFFSET(http_seekable), AV_OPT_TYPE_BOOL, { .i64 = -1}, -1, 1, FLAGS},
+    {"prefetch", "Number of upcoming segments to download in advance for each playlist",
+        OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0}, 0, MAX_PREFETCH, FLAGS},
+    {"prefetch_size", "Maximum number of bytes buffered for each prefetched segment",
+        OFFSET(prefetch_size), AV_OPT_TYPE_INT, {.i64 = 4 << 20}, INITIAL_BUFFER_SIZE, INT_MAX, FLAGS},
     {NULL}
 };
 
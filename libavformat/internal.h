@@ -802,6 +802,15 @@ int ff_copy_whiteblacklists(AVFormatContext *dst, const AVFormatContext *src);
  */
 int ff_format_output_open(AVFormatContext *s, const char *url, AVDictionary **options);
 
+/**
+ * Open an IO stream like AVFormatContext.io_open, but use the given interrupt
+ * callback instead of s->interrupt_callback. If io_open was replaced by the
+ * caller, it is called as is and int_cb is ignored.
+ */
+int ff_format_io_open_cb(AVFormatContext *s, AVIOContext **pb, const char *url,
+                         int flags, const AVIOInterruptCB *int_cb,
+                         AVDictionary **options);
+
 /*
  * A wrapper around AVFormatContext.io_close that should be used
  * instead of calling the pointer directly.
@@ -155,6 +155,24 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * Position in the sample tables, used to build index entries on demand.
+ */
+typedef struct MOVLazyIndex {
+    unsigned int sample;      ///< next sample to add to the index
+    unsigned int chunk;
+    unsigned int chunk_sample;
+    unsigned int stsc_index;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    unsigned int stss_index;
+    unsigned int ctts_index;
+    unsigned int ctts_sample;
+    unsigned int distance;
+    int64_t offset;
+    int64_t dts;
+} MOVLazyIndex;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int pb_is_copied;
@@ -191,6 +209,13 @@ typedef struct MOVStreamContext {
     int64_t min_corrected_pts;  ///< minimum Composition time shown by the edits excluding empty edits.
     int current_sample;
     int64_t current_index;
+    int lazy_index;       ///< index_entries only holds a window of the samples
+    int index_base;       ///< sample number of the first entry of index_entries
+    unsigned int lazy_sample_count; ///< number of samples described by the tables
+    int64_t lazy_start_dts; ///< dts of the first sample
+    int64_t lazy_edit_start; ///< pts range of the edit, samples outside it are discarded
+    int64_t lazy_edit_end;
+    MOVLazyIndex lazy;    ///< position after the last entry of index_entries
     MOVIndexRange* index_ranges;
     MOVIndexRange* current_index_range;
     unsigned int bytes_per_frame;
@@ -267,6 +292,7 @@ typedef struct MOVContext {
     int use_absolute_path;
     int ignore_editlist;
     int advanced_editlist;
+    int lazy_index;
     int ignore_chapters;
     int seek_individually;
     int64_t next_root_atom; ///< offset of the next root atom
@@ -3922,6 +3922,467 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
     msc->current_index = msc->index_ranges[0].start;
 }
 
+/* Expand ctts entries such that we have a 1-1 mapping with samples */
+static int mov_expand_ctts(MOVStreamContext *sc)
+{
+    MOVStts *ctts_data_old = sc->ctts_data;
+    unsigned int ctts_count_old = sc->ctts_count;
+    unsigned int i, j;
+
+    if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
+        return AVERROR(EINVAL);
+    sc->ctts_count = 0;
+    sc->ctts_allocated_size = 0;
+    sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
+                            sc->sample_count * sizeof(*sc->ctts_data));
+    if (!sc->ctts_data) {
+        av_free(ctts_data_old);
+        return AVERROR(ENOMEM);
+    }
+
+    memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
+
+    for (i = 0; i < ctts_count_old &&
+                sc->ctts_count < sc->sample_count; i++)
+        for (j = 0; j < ctts_data_old[i].count &&
+                    sc->ctts_count < sc->sample_count; j++)
+            add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
+                           &sc->ctts_allocated_size, 1,
+                           ctts_data_old[i].duration);
+    av_free(ctts_data_old);
+    return 0;
+}
+
+#define MOV_LAZY_INDEX_SIZE 4096
+
+/*
+ * mov_fix_index() drops the samples before the sync sample preceding the
+ * start of the edit, and the samples after its end. Check that it would only
+ * drop audio samples after the end, which mov_lazy_index_init() leaves out.
+ */
+static int mov_lazy_index_check_edit(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    const MOVElst *e = &sc->elst_data[sc->elst_count - 1];
+    int key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    int64_t search = e->time, dts = 0, n = 0;
+    int64_t sample = 1;
+    unsigned int i;
+
+    if (e->time < 0 || mov->time_scale <= 0)
+        return 0;
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+        if (sc->ctts_count)
+            return 0;
+        search -= sc->time_scale;
+    }
+
+    /* the first sample after the first one the edit could start from */
+    if (sc->keyframe_count) {
+        for (i = 0; i < sc->keyframe_count && sc->keyframes[i] - key_off <= 0; i++);
+        sample = i < sc->keyframe_count ? sc->keyframes[i] - key_off : INT64_MAX;
+    }
+
+    for (i = 0; i < sc->stts_count; i++) {
+        const MOVStts *t = &sc->stts_data[i];
+
+        if (sample >= n && sample - n < t->count &&
+            dts + (sample - n) * t->duration <= search)
+            return 0;
+        dts += t->count * (int64_t)t->duration;
+        n   += t->count;
+    }
+
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO &&
+        e->time + av_rescale(e->duration, sc->time_scale, mov->time_scale) < dts)
+        return 0;
+
+    return 1;
+}
+
+/*
+ * Check whether the index of a track can be built on demand from the sample
+ * tables. This is restricted to long audio and video tracks with well-formed
+ * tables that do not need the whole index to apply the edit list.
+ */
+static int mov_lazy_index_check(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    unsigned int i;
+
+    if (!mov->lazy_index || sc->sample_count <= MOV_LAZY_INDEX_SIZE ||
+        st->nb_index_entries)
+        return 0;
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO &&
+        st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+        return 0;
+    if (!sc->chunk_count || !sc->stsc_count || !sc->stts_count)
+        return 0;
+    /* uncompressed audio chunk demuxing */
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+        sc->stts_count == 1 && sc->stts_data[0].duration == 1)
+        return 0;
+    if (!mov->ignore_editlist && mov->advanced_editlist &&
+        sc->elst_count > 1 + (sc->elst_data[0].time == -1))
+        return 0;
+    if (sc->stps_count || sc->rap_group_count ||
+        (sc->keyframe_absent && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO))
+        return 0;
+    if ((sc->sample_size && sc->sample_size != sc->stsz_sample_size) ||
+        (!sc->stsz_sample_size && !sc->sample_sizes) ||
+        sc->stsz_sample_size > 0x3FFFFFFF)
+        return 0;
+
+    for (i = 0; i < sc->stts_count; i++)
+        if (!sc->stts_data[i].count || sc->stts_data[i].duration < 0)
+            return 0;
+    if (sc->stsc_data[0].first != 1)
+        return 0;
+    for (i = 0; i < sc->stsc_count; i++)
+        if (!sc->stsc_data[i].count ||
+            (i && sc->stsc_data[i].first <= sc->stsc_data[i - 1].first) ||
+            (sc->pseudo_stream_id != -1 && sc->stsc_data[i].id - 1 != sc->pseudo_stream_id))
+            return 0;
+    for (i = 1; i < sc->keyframe_count; i++)
+        if (sc->keyframes[i] <= sc->keyframes[i - 1])
+            return 0;
+    if (!sc->stsz_sample_size)
+        for (i = 0; i < sc->sample_count; i++)
+            if (sc->sample_sizes[i] > 0x3FFFFFFF)
+                return 0;
+    if (!mov->ignore_editlist && mov->advanced_editlist && sc->elst_count &&
+        !mov_lazy_index_check_edit(mov, st))
+        return 0;
+
+    return 1;
+}
+
+/* Move the position in the sample tables to the given sample. */
+static void mov_lazy_index_set(MOVStreamContext *sc, unsigned int sample)
+{
+    MOVLazyIndex *l = &sc->lazy;
+    int key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    unsigned int i, n;
+
+    l->sample = sample;
+
+    l->dts = sc->lazy_start_dts;
+    for (i = 0, n = sample; i + 1 < sc->stts_count && n >= sc->stts_data[i].count; i++) {
+        l->dts += sc->stts_data[i].count * (int64_t)sc->stts_data[i].duration;
+        n -= sc->stts_data[i].count;
+    }
+    l->stts_index  = i;
+    l->stts_sample = n;
+    l->dts += n * (int64_t)sc->stts_data[i].duration;
+
+    for (i = 0, n = sample; mov_stsc_index_valid(i, sc->stsc_count) &&
+                            n >= mov_get_stsc_samples(sc, i); i++)
+        n -= mov_get_stsc_samples(sc, i);
+    l->stsc_index   = i;
+    l->chunk        = sc->stsc_data[i].first - 1 + n / sc->stsc_data[i].count;
+    l->chunk_sample = n % sc->stsc_data[i].count;
+
+    l->offset = sc->chunk_offsets[l->chunk];
+    for (i = sample - l->chunk_sample; i < sample; i++)
+        l->offset += sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[i];
+
+    for (i = 0, n = sample; i < sc->ctts_count && n >= sc->ctts_data[i].count; i++)
+        n -= sc->ctts_data[i].count;
+    l->ctts_index  = i;
+    l->ctts_sample = n;
+
+    l->distance = 0;
+    if (sc->keyframe_count) {
+        unsigned int lo = 0, hi = sc->keyframe_count;
+
+        /* find the first sync sample at or after this sample */
+        while (lo < hi) {
+            unsigned int mid = (lo + hi) / 2;
+            if (sc->keyframes[mid] < sample + (int64_t)key_off)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        l->stss_index = FFMIN(lo, sc->keyframe_count - 1);
+        l->distance   = lo ? sample - (sc->keyframes[lo - 1] - key_off) : sample;
+    }
+}
+
+/* Replace the index entries by the samples in [start, end). */
+static int mov_lazy_index_load(MOVContext *mov, AVStream *st,
+                               unsigned int start, unsigned int end)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *l = &sc->lazy;
+    int key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    AVIndexEntry *entries;
+
+    entries = av_fast_realloc(st->index_entries,
+                              &st->index_entries_allocated_size,
+                              (end - start) * sizeof(*st->index_entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    st->index_entries    = entries;
+    st->nb_index_entries = 0;
+    sc->index_base       = start;
+
+    if (l->sample != start)
+        mov_lazy_index_set(sc, start);
+
+    for (; l->sample < end; l->sample++) {
+        AVIndexEntry *e = &st->index_entries[st->nb_index_entries++];
+        unsigned int sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size :
+                                   sc->sample_sizes[l->sample];
+        int64_t duration = sc->stts_data[l->stts_index].duration;
+        int64_t pts = l->dts + sc->dts_shift;
+        int keyframe = 1;
+
+        if (sc->keyframe_count) {
+            keyframe = l->sample + key_off == sc->keyframes[l->stss_index];
+            if (keyframe && l->stss_index + 1 < sc->keyframe_count)
+                l->stss_index++;
+        }
+        if (keyframe)
+            l->distance = 0;
+
+        e->pos          = l->offset;
+        e->timestamp    = l->dts;
+        e->size         = sample_size;
+        e->min_distance = l->distance;
+        e->flags        = keyframe ? AVINDEX_KEYFRAME : 0;
+
+        if (l->ctts_index < sc->ctts_count) {
+            pts += sc->ctts_data[l->ctts_index].duration;
+            if (++l->ctts_sample == sc->ctts_data[l->ctts_index].count) {
+                l->ctts_index++;
+                l->ctts_sample = 0;
+            }
+        }
+        /* discard the samples outside the edit as mov_fix_index() does, but
+         * keep the audio sample it starts in */
+        if (pts >= sc->lazy_edit_end ||
+            (pts < sc->lazy_edit_start &&
+             (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO ||
+              st->codecpar->codec_id == AV_CODEC_ID_VORBIS ||
+              pts + duration <= sc->lazy_edit_start)))
+            e->flags |= AVINDEX_DISCARD_FRAME;
+
+        l->offset += sample_size;
+        l->distance++;
+        if (++l->chunk_sample == sc->stsc_data[l->stsc_index].count) {
+            l->chunk_sample = 0;
+            if (++l->chunk < sc->chunk_count)
+                l->offset = sc->chunk_offsets[l->chunk];
+            if (mov_stsc_index_valid(l->stsc_index, sc->stsc_count) &&
+                l->chunk + 1 == sc->stsc_data[l->stsc_index + 1].first)
+                l->stsc_index++;
+        }
+        l->dts += duration;
+        if (++l->stts_sample == sc->stts_data[l->stts_index].count &&
+            l->stts_index + 1 < sc->stts_count) {
+            l->stts_sample = 0;
+            l->stts_index++;
+        }
+    }
+
+    return 0;
+}
+
+/* Make sure the given sample is in the index entries, if it exists. */
+static int mov_lazy_index_update(MOVContext *mov, AVStream *st, int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (sample < 0 || sample >= sc->lazy_sample_count ||
+        (sample >= sc->index_base && sample - sc->index_base < st->nb_index_entries))
+        return 0;
+
+    return mov_lazy_index_load(mov, st, sample,
+                               FFMIN(sample + (int64_t)MOV_LAZY_INDEX_SIZE,
+                                     sc->lazy_sample_count));
+}
+
+/*
+ * Load the index entries around the given dts: from the sync sample at or
+ * before it up to the sync sample after it.
+ */
+static int mov_lazy_index_seek(MOVContext *mov, AVStream *st, int64_t timestamp)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    unsigned int sample = 0, start, end, i;
+    int64_t dts = sc->lazy_start_dts;
+
+    /* find the last sample with a dts not after the timestamp */
+    for (i = 0; i < sc->stts_count && timestamp >= dts; i++) {
+        int64_t duration = sc->stts_data[i].duration;
+        int64_t count = i + 1 < sc->stts_count ? sc->stts_data[i].count :
+                        FFMAX(sc->lazy_sample_count - (int64_t)sample, 0);
+
+        if (duration && timestamp < dts + count * duration) {
+            sample += (timestamp - dts) / duration;
+            break;
+        }
+        dts    += count * duration;
+        sample += count;
+    }
+    if (sample && timestamp >= dts && i == sc->stts_count)
+        sample--;
+    sample = FFMIN(sample, sc->lazy_sample_count - 1);
+
+    start = sample;
+    end   = sample + 2;
+    if (sc->keyframe_count) {
+        unsigned int lo = 0, hi = sc->keyframe_count;
+
+        /* find the first sync sample after this sample */
+        while (lo < hi) {
+            unsigned int mid = (lo + hi) / 2;
+            if (sc->keyframes[mid] <= sample + (int64_t)key_off)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        start = lo ? FFMIN(sc->keyframes[lo - 1] - key_off, sample) : 0;
+        end   = lo < sc->keyframe_count ? FFMAX(sc->keyframes[lo] - key_off + 1, end) :
+                                          sc->lazy_sample_count;
+    }
+    end = FFMIN(FFMAX(end, start + (int64_t)MOV_LAZY_INDEX_SIZE), sc->lazy_sample_count);
+
+    if (start >= sc->index_base && end <= sc->index_base + st->nb_index_entries)
+        return 0;
+    return mov_lazy_index_load(mov, st, start, end);
+}
+
+/* Build the whole index, used when samples are added from fragments. */
+static int mov_lazy_index_finish(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int ret;
+
+    if ((ret = mov_lazy_index_load(mov, st, 0, sc->lazy_sample_count)) < 0)
+        return ret;
+    if (sc->ctts_data && (ret = mov_expand_ctts(sc)) < 0)
+        return ret;
+    sc->lazy_index = 0;
+    return 0;
+}
+
+static int mov_lazy_index_init(MOVContext *mov, AVStream *st, int64_t start_dts)
+{
+    MOVStreamContext *sc = st->priv_data;
+    uint64_t stream_size = 0;
+    int64_t samples = 0;
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < sc->stsc_count; i++)
+        samples += mov_get_stsc_samples(sc, i);
+    if (samples > sc->sample_count)
+        av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
+    sc->lazy_sample_count = FFMIN(samples, sc->sample_count);
+    sc->lazy_start_dts    = start_dts;
+
+    if (sc->stsz_sample_size > 0)
+        stream_size = sc->stsz_sample_size * (uint64_t)sc->lazy_sample_count;
+    else
+        for (i = 0; i < sc->lazy_sample_count; i++)
+            stream_size += sc->sample_sizes[i];
+    if (st->duration > 0)
+        st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+
+    /* mov_fix_index() stops at the first audio sample that reaches the end of
+     * the edit */
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && sc->lazy_edit_end != INT64_MAX) {
+        int64_t pts = start_dts + sc->dts_shift;
+        int64_t n = 0;
+
+        for (i = 0; i < sc->stts_count && n < sc->lazy_sample_count; i++) {
+            int64_t duration = sc->stts_data[i].duration;
+            int64_t count = sc->lazy_sample_count - n;
+
+            if (i + 1 < sc->stts_count)
+                count = FFMIN(count, sc->stts_data[i].count);
+            if (duration && pts + count * duration >= sc->lazy_edit_end) {
+                n += FFMAX((sc->lazy_edit_end - pts + duration - 1) / duration, 1);
+                sc->lazy_sample_count = n;
+                break;
+            }
+            pts += count * duration;
+            n   += count;
+        }
+    }
+
+    mov_lazy_index_set(sc, 0);
+    ret = mov_lazy_index_load(mov, st, 0, FFMIN(MOV_LAZY_INDEX_SIZE, sc->lazy_sample_count));
+    if (ret < 0) {
+        st->nb_index_entries = 0;
+        return ret;
+    }
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        for (i = 0; i < FFMIN(st->nb_index_entries, 99); i++)
+            ff_rfps_add_frame(mov->fc, st, st->index_entries[i].timestamp);
+
+    /* as set by mov_fix_index() */
+    if (sc->lazy_edit_start != INT64_MIN) {
+        st->start_time = sc->lazy_edit_start;
+        st->duration   = FFMIN(st->duration, sc->lazy_edit_end);
+    }
+
+    /* The edit list is applied by offsetting the timestamps. mov_fix_index()
+     * also retimes the samples from the first one in the edit, and the video
+     * so that its earliest sample in the edit starts it. Do the same, and use
+     * the same minimum pts, so that seeking behaves the same. */
+    if (sc->lazy_edit_start != INT64_MIN) {
+        int64_t empty_duration = sc->lazy_edit_start;
+        int64_t offset = INT64_MIN, min_pts = INT64_MAX;
+        unsigned int ctts_index = 0, ctts_sample = 0;
+
+        for (i = 0; i < st->nb_index_entries; i++) {
+            const AVIndexEntry *e = &st->index_entries[i];
+            int64_t pts = e->timestamp + sc->dts_shift;
+
+            if (e->timestamp >= min_pts)
+                break;
+            if (ctts_index < sc->ctts_count) {
+                pts += sc->ctts_data[ctts_index].duration;
+                if (++ctts_sample == sc->ctts_data[ctts_index].count) {
+                    ctts_index++;
+                    ctts_sample = 0;
+                }
+            }
+            if (e->flags & AVINDEX_DISCARD_FRAME)
+                continue;
+            /* audio sample the edit starts in, already in place */
+            if (pts < empty_duration) {
+                if (offset == INT64_MIN)
+                    offset = 0;
+                continue;
+            }
+            if (offset == INT64_MIN)
+                offset = e->timestamp + sc->dts_shift - empty_duration;
+            min_pts = FFMIN(min_pts, pts);
+        }
+        if (min_pts != INT64_MAX) {
+            sc->min_corrected_pts = min_pts - offset - empty_duration;
+            if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sc->min_corrected_pts > 0)
+                offset += sc->min_corrected_pts;
+            if (offset) {
+                for (i = 0; i < st->nb_index_entries; i++)
+                    st->index_entries[i].timestamp -= offset;
+                sc->lazy.dts        -= offset;
+                sc->lazy_start_dts  -= offset;
+                sc->lazy_edit_start -= offset;
+                sc->lazy_edit_end   -= offset;
+            }
+        }
+    }
+
+    av_log(mov->fc, AV_LOG_DEBUG, "stream %d: building the index on demand for %u samples\n",
+           st->index, sc->lazy_sample_count);
+    return 0;
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
@@ -3933,8 +4394,10 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     unsigned int stps_index = 0;
     unsigned int i, j;
     uint64_t stream_size = 0;
-    MOVStts *ctts_data_old = sc->ctts_data;
-    unsigned int ctts_count_old = sc->ctts_count;
+
+    sc->lazy_index = mov_lazy_index_check(mov, st);
+    sc->lazy_edit_start = INT64_MIN;
+    sc->lazy_edit_end   = INT64_MAX;
 
     if (sc->elst_count) {
         int i, edit_start_index = 0, multiple_edits = 0;
@@ -3970,11 +4433,19 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
 
             sc->time_offset = start_time -  (uint64_t)empty_duration;
             sc->min_corrected_pts = start_time;
-            if (!mov->advanced_editlist)
+            if (!mov->advanced_editlist || sc->lazy_index)
                 current_dts = -sc->time_offset;
         }
 
-        if (!multiple_edits && !mov->advanced_editlist &&
+        /* the samples outside the edit are discarded while loading the index */
+        if (sc->lazy_index && mov->advanced_editlist) {
+            sc->lazy_edit_start = empty_duration;
+            sc->lazy_edit_end   = empty_duration +
+                av_rescale(sc->elst_data[edit_start_index].duration,
+                           sc->time_scale, mov->time_scale);
+        }
+
+        if (!multiple_edits && (!mov->advanced_editlist || sc->lazy_index) &&
             st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
             sc->start_pad = start_time;
     }
@@ -3998,6 +4469,11 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
 
         if (!sc->sample_count || st->nb_index_entries)
             return;
+        if (sc->lazy_index) {
+            if (mov_lazy_index_init(mov, st, current_dts) < 0)
+                return;
+            goto done;
+        }
         if (sc->sample_count >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
             return;
         if (av_reallocp_array(&st->index_entries,
@@ -4008,30 +4484,8 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
         st->index_entries_allocated_size = (st->nb_index_entries + sc->sample_count) * sizeof(*st->index_entries);
 
-        if (ctts_data_old) {
-            // Expand ctts entries such that we have a 1-1 mapping with samples
-            if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
-                return;
-            sc->ctts_count = 0;
-            sc->ctts_allocated_size = 0;
-            sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
-                                    sc->sample_count * sizeof(*sc->ctts_data));
-            if (!sc->ctts_data) {
-                av_free(ctts_data_old);
-                return;
-            }
-
-            memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
-
-            for (i = 0; i < ctts_count_old &&
-                        sc->ctts_count < sc->sample_count; i++)
-                for (j = 0; j < ctts_data_old[i].count &&
-                            sc->ctts_count < sc->sample_count; j++)
-                    add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
-                                   &sc->ctts_allocated_size, 1,
-                                   ctts_data_old[i].duration);
-            av_free(ctts_data_old);
-        }
+        if (sc->ctts_data && mov_expand_ctts(sc) < 0)
+            return;
 
         for (i = 0; i < sc->chunk_count; i++) {
             int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
@@ -4243,6 +4697,7 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         mov_fix_index(mov, st);
     }
 
+done:
     // Update start time of the stream.
     if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && st->nb_index_entries > 0) {
         st->start_time = st->index_entries[0].timestamp + sc->dts_shift;
@@ -4482,11 +4937,13 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             st->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
+    /* Do not need those anymore, unless the index is built on demand. */
+    if (!sc->lazy_index) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stts_data);
+    }
     av_freep(&sc->stps_data);
     av_freep(&sc->elst_data);
     av_freep(&sc->rap_group);
@@ -4912,7 +5369,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     int64_t dts, pts = AV_NOPTS_VALUE;
     int data_offset = 0;
     unsigned entries, first_sample_flags = frag->flags;
-    int flags, distance, i;
+    int flags, distance, i, ret;
     int64_t prev_dts = AV_NOPTS_VALUE;
     int next_frag_index = -1, index_entry_pos;
     size_t requested_size;
@@ -4938,6 +5395,8 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc = st->priv_data;
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
+    if (sc->lazy_index && (ret = mov_lazy_index_finish(c, st)) < 0)
+        return ret;
 
     // Find the next frag_index index that has a valid index_entry for
     // the current track_id.
@@ -7972,8 +8431,12 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *avst = s->streams[i];
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample];
+        if (msc->lazy_index &&
+            mov_lazy_index_update(s->priv_data, avst, msc->current_sample) < 0)
+            av_log(s, AV_LOG_ERROR, "stream %d: failed to load the index\n", i);
+        if (msc->pb && msc->current_sample >= msc->index_base &&
+            msc->current_sample - msc->index_base < avst->nb_index_entries) {
+            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample - msc->index_base];
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
             if (!sample || (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) && current_sample->pos < sample->pos) ||
@@ -8176,8 +8639,12 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             sc->ctts_sample = 0;
         }
     } else {
-        int64_t next_dts = (sc->current_sample < st->nb_index_entries) ?
-            st->index_entries[sc->current_sample].timestamp : st->duration;
+        int64_t next_dts = st->duration;
+
+        if (sc->current_sample - sc->index_base < st->nb_index_entries)
+            next_dts = st->index_entries[sc->current_sample - sc->index_base].timestamp;
+        else if (sc->lazy_index && sc->current_sample < sc->lazy_sample_count)
+            next_dts = sc->lazy.dts;
 
         if (next_dts >= pkt->dts)
             pkt->duration = next_dts - pkt->dts;
@@ -8256,12 +8723,16 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
+    if (sc->lazy_index && (ret = mov_lazy_index_seek(s->priv_data, st, timestamp)) < 0)
+        return ret;
+
     sample = av_index_search_timestamp(st, timestamp, flags);
     av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
     if (sample < 0 && st->nb_index_entries && timestamp < st->index_entries[0].timestamp)
         sample = 0;
     if (sample < 0) /* not sure what to do */
         return AVERROR_INVALIDDATA;
+    sample += sc->index_base;
     mov_current_sample_set(sc, sample);
     av_log(s, AV_LOG_TRACE, "stream %d, found sample %d\n", st->index, sc->current_sample);
     /* adjust ctts index */
@@ -8299,8 +8770,8 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 static int64_t mov_get_skip_samples(AVStream *st, int sample)
 {
     MOVStreamContext *sc = st->priv_data;
-    int64_t first_ts = st->index_entries[0].timestamp;
-    int64_t ts = st->index_entries[sample].timestamp;
+    int64_t first_ts = sc->lazy_index ? sc->lazy_start_dts : st->index_entries[0].timestamp;
+    int64_t ts = st->index_entries[sample - sc->index_base].timestamp;
     int64_t off;
 
     if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
@@ -8329,7 +8800,8 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = st->index_entries[sample].timestamp;
+        MOVStreamContext *sc = st->priv_data;
+        int64_t seek_timestamp = st->index_entries[sample - sc->index_base].timestamp;
         st->internal->skip_samples = mov_get_skip_samples(st, sample);
 
         for (i = 0; i < s->nb_streams; i++) {
@@ -8382,6 +8854,10 @@ static const AVOption mov_options[] = {
         "Modify the AVIndex according to the editlists. Use this option to decode in the order specified by the edits.",
         OFFSET(advanced_editlist), AV_OPT_TYPE_BOOL, {.i64 = 1},
         0, 1, FLAGS},
+    {"lazy_index",
+        "Build the index of long tracks on demand while reading. Use this option to open long files faster.",
+        OFFSET(lazy_index), AV_OPT_TYPE_BOOL, {.i64 = 0},
+        0, 1, FLAGS},
     {"ignore_chapters", "", OFFSET(ignore_chapters), AV_OPT_TYPE_BOOL, {.i64 = 0},
         0, 1, FLAGS},
     {"use_mfra_for",
@@ -62,6 +62,7 @@ static const AVOption options[] = {
     { "movflags", "MOV muxer flags", offsetof(MOVMuxContext, flags), AV_OPT_TYPE_FLAGS, {.i64 = 0}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "rtphint", "Add RTP hint tracks", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RTP_HINT}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "moov_size", "maximum moov size so it can be placed at the begin", offsetof(MOVMuxContext, reserved_moov_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, 0 },
+    { "expected_duration", "expected output duration used to estimate the reserved moov size", offsetof(MOVMuxContext, expected_duration), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, INT64_MAX, AV_OPT_FLAG_ENCODING_PARAM, 0 },
     { "empty_moov", "Make the initial moov atom empty", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_EMPTY_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "frag_keyframe", "Fragment at video keyframes", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_KEYFRAME}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "frag_every_frame", "Fragment at every frame", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_EVERY_FRAME}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
@@ -69,6 +70,7 @@ static const AVOption options[] = {
     { "frag_custom", "Flush fragments on caller requests", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_CUSTOM}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "isml", "Create a live smooth streaming feed (for pushing to a publishing point)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_ISML}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "faststart", "Run a second pass to put the index (moov atom) at the beginning of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FASTSTART}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
+    { "reserve_moov", "Reserve estimated space for the moov atom at the beginning of the file, only running a second pass if it does not fit", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RESERVE_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "omit_tfhd_offset", "Omit the base data offset in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_OMIT_TFHD_OFFSET}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "disable_chpl", "Disable Nero chapter atom", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_DISABLE_CHPL}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "default_base_moof", "Set the default-base-is-moof flag in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_DEFAULT_BASE_MOOF}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
@@ -6485,6 +6487,72 @@ static int mov_create_dvd_sub_decoder_specific_info(MOVTrack *track,
     return 0;
 }
 
+/*
+ * Estimate an upper bound of the moov size from the stream parameters and the
+ * expected duration, assuming one chunk per sample and no run-length coding of
+ * the sample tables. This must be called before mov_init() changes the stream
+ * time bases. Returns 0 if the duration or the packet rate is unknown.
+ */
+static int64_t estimate_moov_size(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVDictionaryEntry *t = NULL;
+    int64_t duration = mov->expected_duration;
+    int64_t size = 4096;
+    int i;
+
+    if (!duration && s->duration > 0)
+        duration = s->duration;
+    if (!duration) {
+        for (i = 0; i < s->nb_streams; i++) {
+            AVStream *st = s->streams[i];
+            if (st->duration > 0)
+                duration = FFMAX(duration, av_rescale_q(st->duration, st->time_base,
+                                                        AV_TIME_BASE_Q));
+        }
+    }
+    if (duration <= 0)
+        return 0;
+
+    while ((t = av_dict_get(s->metadata, "", t, AV_DICT_IGNORE_SUFFIX)))
+        size += strlen(t->key) + strlen(t->value) + 32;
+    size += s->nb_chapters * 256LL;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        AVRational rate;
+        /* stts + stsz + stco/co64 + stsc, and ctts + stss + sdtp for video */
+        int entry_size = 8 + 4 + 8 + 12;
+
+        t = NULL;
+        while ((t = av_dict_get(st->metadata, "", t, AV_DICT_IGNORE_SUFFIX)))
+            size += strlen(t->key) + strlen(t->value) + 32;
+        size += 1024 + par->extradata_size;
+        if (is_cover_image(st))
+            continue;
+
+        switch (par->codec_type) {
+        case AVMEDIA_TYPE_VIDEO:
+            rate = st->avg_frame_rate;
+            entry_size += 8 + 4 + 1;
+            break;
+        case AVMEDIA_TYPE_AUDIO:
+            rate = av_make_q(par->sample_rate, par->frame_size > 0 ? par->frame_size : 1024);
+            break;
+        default:
+            rate = av_make_q(2, 1);
+            break;
+        }
+        if (rate.num <= 0 || rate.den <= 0)
+            return 0;
+        size += av_rescale(duration, rate.num, rate.den * (int64_t)AV_TIME_BASE) * entry_size;
+    }
+
+    /* leave some room for timestamp jitter and variable frame rates */
+    return size + size / 16;
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6538,6 +6606,25 @@ static int mov_init(AVFormatContext *s)
         mov->flags &= ~FF_MOV_FLAG_SKIP_SIDX;
     }
 
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+        if (mov->flags & FF_MOV_FLAG_FRAGMENT) {
+            av_log(s, AV_LOG_WARNING, "The reserve_moov flag is not supported with fragmented output, ignoring\n");
+            mov->flags &= ~FF_MOV_FLAG_RESERVE_MOOV;
+        } else if (!mov->reserved_moov_size) {
+            int64_t size = estimate_moov_size(s);
+            if (size <= 0 || size > INT_MAX) {
+                av_log(s, AV_LOG_WARNING, "Unable to estimate the moov size, falling back to faststart\n");
+                mov->flags &= ~FF_MOV_FLAG_RESERVE_MOOV;
+                mov->flags |= FF_MOV_FLAG_FASTSTART;
+            } else {
+                av_log(s, AV_LOG_VERBOSE, "Reserving %"PRId64" bytes for the moov atom\n", size);
+                mov->reserved_moov_size = size;
+            }
+        }
+        if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV)
+            mov->flags &= ~FF_MOV_FLAG_FASTSTART;
+    }
+
     if (mov->flags & FF_MOV_FLAG_FASTSTART) {
         mov->reserved_moov_size = -1;
     }
@@ -7045,9 +7132,11 @@ static int compute_sidx_size(AVFormatContext *s)
     return sidx_size;
 }
 
+#define SHIFT_DATA_MIN_CHUNK (1 << 20)
+
 static int shift_data(AVFormatContext *s)
 {
-    int ret = 0, moov_size;
+    int ret = 0, moov_size, buf_size;
     MOVMuxContext *mov = s->priv_data;
     int64_t pos, pos_end;
     uint8_t *buf, *read_buf[2];
@@ -7062,11 +7151,13 @@ static int shift_data(AVFormatContext *s)
     if (moov_size < 0)
         return moov_size;
 
-    buf = av_malloc(moov_size * 2);
+    /* the data can be moved in chunks of any size not smaller than the shift */
+    buf_size = FFMAX(moov_size, SHIFT_DATA_MIN_CHUNK);
+    buf = av_malloc(buf_size * 2);
     if (!buf)
         return AVERROR(ENOMEM);
     read_buf[0] = buf;
-    read_buf[1] = buf + moov_size;
+    read_buf[1] = buf + buf_size;
 
     /* Shift the data: the AVIO context of the output can only be used for
      * writing, so we re-open the same output, but for reading. It also avoids
@@ -7089,11 +7180,11 @@ static int shift_data(AVFormatContext *s)
     pos = avio_tell(read_pb);
 
 #define READ_BLOCK do {                                                             \
-    read_size[read_buf_id] = avio_read(read_pb, read_buf[read_buf_id], moov_size);  \
+    read_size[read_buf_id] = avio_read(read_pb, read_buf[read_buf_id], buf_size);   \
     read_buf_id ^= 1;                                                               \
 } while (0)
 
-    /* shift data by chunk of at most moov_size */
+    /* shift data by chunk of at most buf_size */
     READ_BLOCK;
     do {
         int n;
@@ -7177,6 +7268,23 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
+        if (mov->reserved_moov_size > 0 && mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+            int moov_size = get_moov_size(s);
+            if (moov_size < 0)
+                return moov_size;
+            if (mov->reserved_moov_size - moov_size < 8) {
+                /* turn the reserved space into a free atom and move it along
+                 * with the mdat */
+                av_log(s, AV_LOG_WARNING, "Reserved moov space of %d bytes is too small, needed %d\n",
+                       mov->reserved_moov_size, moov_size + 8);
+                avio_wb32(pb, mov->reserved_moov_size);
+                ffio_wfourcc(pb, "free");
+                /* shift_data() moves everything up to the current position */
+                avio_seek(pb, moov_pos, SEEK_SET);
+                mov->flags |= FF_MOV_FLAG_FASTSTART;
+            }
+        }
+
         if (mov->flags & FF_MOV_FLAG_FASTSTART) {
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
             res = shift_data(s);
@@ -166,8 +166,9 @@ static const AVClass av_format_context_class = {
     .get_category   = get_category,
 };
 
-static int io_open_default(AVFormatContext *s, AVIOContext **pb,
-                           const char *url, int flags, AVDictionary **options)
+static int io_open_cb(AVFormatContext *s, AVIOContext **pb, const char *url,
+                      int flags, const AVIOInterruptCB *int_cb,
+                      AVDictionary **options)
 {
     int loglevel;
 
@@ -184,11 +185,26 @@ static int io_open_default(AVFormatContext *s, AVIOContext **pb,
 #if FF_API_OLD_OPEN_CALLBACKS
 FF_DISABLE_DEPRECATION_WARNINGS
     if (s->open_cb)
-        return s->open_cb(s, pb, url, flags, &s->interrupt_callback, options);
+        return s->open_cb(s, pb, url, flags, int_cb, options);
 FF_ENABLE_DEPRECATION_WARNINGS
 #endif
 
-    return ffio_open_whitelist(pb, url, flags, &s->interrupt_callback, options, s->protocol_whitelist, s->protocol_blacklist);
+    return ffio_open_whitelist(pb, url, flags, int_cb, options, s->protocol_whitelist, s->protocol_blacklist);
+}
+
+static int io_open_default(AVFormatContext *s, AVIOContext **pb,
+                           const char *url, int flags, AVDictionary **options)
+{
+    return io_open_cb(s, pb, url, flags, &s->interrupt_callback, options);
+}
+
+int ff_format_io_open_cb(AVFormatContext *s, AVIOContext **pb, const char *url,
+                         int flags, const AVIOInterruptCB *int_cb,
+                         AVDictionary **options)
+{
+    if (s->io_open != io_open_default)
+        return s->io_open(s, pb, url, flags, options);
+    return io_open_cb(s, pb, url, flags, int_cb, options);
 }
 
 static void io_close_default(AVFormatContext *s, AVIOContext *pb)
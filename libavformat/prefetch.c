@@ -0,0 +1,289 @@
+/*
+ * Background download of media segments
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "avio_internal.h"
+#include "internal.h"
+#include "prefetch.h"
+
+#define PREFETCH_READ_SIZE 32768
+
+static void prefetch_free_desc(FFPrefetch *p)
+{
+    av_freep(&p->url);
+    av_dict_free(&p->opts);
+    av_dict_free(&p->seg_opts);
+    p->seq_no = -1;
+}
+
+void ff_prefetch_init(FFPrefetch *p, FFPrefetchGroup *g)
+{
+    memset(p, 0, sizeof(*p));
+    p->group  = g;
+    p->seq_no = -1;
+}
+
+#if HAVE_THREADS
+int ff_prefetch_group_init(FFPrefetchGroup *g, AVFormatContext *s,
+                           int (*open)(AVFormatContext *s, FFPrefetch *p,
+                                       AVIOContext **pb),
+                           int64_t max_buffered, int64_t max_size)
+{
+    int ret;
+
+    g->open         = open;
+    g->max_buffered = max_buffered;
+    g->max_size     = max_size;
+    g->buffered     = 0;
+
+    if ((ret = pthread_mutex_init(&g->mutex, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&g->cond, NULL))) {
+        pthread_mutex_destroy(&g->mutex);
+        return AVERROR(ret);
+    }
+    /* also marks the group as initialized */
+    g->s = s;
+    return 0;
+}
+
+void ff_prefetch_group_uninit(FFPrefetchGroup *g)
+{
+    if (!g->s)
+        return;
+    pthread_mutex_destroy(&g->mutex);
+    pthread_cond_destroy(&g->cond);
+    g->s = NULL;
+}
+
+static int prefetch_interrupt_cb(void *opaque)
+{
+    FFPrefetch *p = opaque;
+
+    return atomic_load(&p->abort) ||
+           ff_check_interrupt(&p->group->s->interrupt_callback);
+}
+
+/* Append data to the fifo, waiting while the limits are reached. */
+static int prefetch_write(FFPrefetch *p, const uint8_t *buf, int size)
+{
+    FFPrefetchGroup *g = p->group;
+    int ret = 0;
+
+    pthread_mutex_lock(&g->mutex);
+    while (!atomic_load(&p->abort) && p->fifo && av_fifo_size(p->fifo) &&
+           (av_fifo_size(p->fifo) + size > g->max_size ||
+            g->buffered + size > g->max_buffered))
+        pthread_cond_wait(&g->cond, &g->mutex);
+
+    if (atomic_load(&p->abort)) {
+        ret = AVERROR_EXIT;
+    } else if (!p->fifo) {
+        if (!(p->fifo = av_fifo_alloc(size)))
+            ret = AVERROR(ENOMEM);
+    } else if (av_fifo_space(p->fifo) < size) {
+        /* makes room for size bytes after the data in the fifo */
+        ret = av_fifo_grow(p->fifo, size);
+    }
+    if (ret >= 0) {
+        av_fifo_generic_write(p->fifo, (void *)buf, size, NULL);
+        g->buffered += size;
+        pthread_cond_broadcast(&g->cond);
+    }
+    pthread_mutex_unlock(&g->mutex);
+
+    return ret;
+}
+
+static void *prefetch_thread(void *arg)
+{
+    FFPrefetch *p = arg;
+    FFPrefetchGroup *g = p->group;
+    AVIOContext *in = NULL;
+    int64_t remaining = p->size;
+    uint8_t *buf;
+    int ret;
+
+    buf = av_malloc(PREFETCH_READ_SIZE);
+    if (!buf) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ret = g->open(g->s, p, &in);
+
+    while (ret >= 0) {
+        int len = PREFETCH_READ_SIZE;
+
+        if (p->size >= 0) {
+            if (!remaining) {
+                ret = AVERROR_EOF;
+                break;
+            }
+            len = FFMIN(len, remaining);
+        }
+        /* pass the data on as it arrives, a live segment may still grow */
+        ret = avio_read_partial(in, buf, len);
+        if (ret <= 0) {
+            ret = ret ? ret : AVERROR_EOF;
+            break;
+        }
+        remaining -= ret;
+
+        ret = prefetch_write(p, buf, ret);
+    }
+
+end:
+    ff_format_io_close(g->s, &in);
+    av_free(buf);
+
+    if (atomic_load(&p->abort))
+        ret = AVERROR_EXIT;
+    else if (ret != AVERROR_EOF)
+        av_log(g->s, AV_LOG_VERBOSE,
+               "Prefetching segment %"PRId64" from '%s' failed: %s\n",
+               p->seq_no, p->url, av_err2str(ret));
+
+    pthread_mutex_lock(&g->mutex);
+    p->done  = 1;
+    p->error = ret == AVERROR_EOF ? 0 : ret;
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->mutex);
+
+    return NULL;
+}
+
+int ff_prefetch_start(FFPrefetch *p, int64_t seq_no)
+{
+    int ret;
+
+    p->seq_no = seq_no;
+    p->done   = 0;
+    p->error  = 0;
+    atomic_init(&p->abort, 0);
+    p->interrupt_callback.callback = prefetch_interrupt_cb;
+    p->interrupt_callback.opaque   = p;
+
+    if ((ret = pthread_create(&p->thread, NULL, prefetch_thread, p))) {
+        prefetch_free_desc(p);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+
+void ff_prefetch_reset(FFPrefetch *p)
+{
+    FFPrefetchGroup *g = p->group;
+
+    if (p->seq_no < 0)
+        return;
+
+    /* wakes up the thread if it waits for the limits, and interrupts its
+     * IO otherwise */
+    atomic_store(&p->abort, 1);
+    pthread_mutex_lock(&g->mutex);
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->mutex);
+    pthread_join(p->thread, NULL);
+
+    if (p->fifo) {
+        pthread_mutex_lock(&g->mutex);
+        g->buffered -= av_fifo_size(p->fifo);
+        pthread_cond_broadcast(&g->cond);
+        pthread_mutex_unlock(&g->mutex);
+        av_fifo_freep(&p->fifo);
+    }
+    prefetch_free_desc(p);
+}
+
+int ff_prefetch_wait(FFPrefetch *p)
+{
+    FFPrefetchGroup *g = p->group;
+    int ret = 0;
+
+    pthread_mutex_lock(&g->mutex);
+    while ((!p->fifo || !av_fifo_size(p->fifo)) && !p->done)
+        pthread_cond_wait(&g->cond, &g->mutex);
+    if ((!p->fifo || !av_fifo_size(p->fifo)) && p->error < 0)
+        ret = p->error;
+    pthread_mutex_unlock(&g->mutex);
+
+    return ret;
+}
+
+int ff_prefetch_read(FFPrefetch *p, uint8_t *buf, int buf_size)
+{
+    FFPrefetchGroup *g = p->group;
+    int ret;
+
+    pthread_mutex_lock(&g->mutex);
+    while ((!p->fifo || !av_fifo_size(p->fifo)) && !p->done)
+        pthread_cond_wait(&g->cond, &g->mutex);
+    ret = p->fifo ? FFMIN(av_fifo_size(p->fifo), buf_size) : 0;
+    if (ret > 0) {
+        av_fifo_generic_read(p->fifo, buf, ret, NULL);
+        g->buffered -= ret;
+        pthread_cond_broadcast(&g->cond);
+    } else {
+        ret = p->error < 0 ? p->error : AVERROR_EOF;
+    }
+    pthread_mutex_unlock(&g->mutex);
+
+    return ret;
+}
+#else
+int ff_prefetch_group_init(FFPrefetchGroup *g, AVFormatContext *s,
+                           int (*open)(AVFormatContext *s, FFPrefetch *p,
+                                       AVIOContext **pb),
+                           int64_t max_buffered, int64_t max_size)
+{
+    g->s            = s;
+    g->open         = open;
+    g->max_buffered = max_buffered;
+    g->max_size     = max_size;
+    return 0;
+}
+
+void ff_prefetch_group_uninit(FFPrefetchGroup *g)
+{
+}
+
+int ff_prefetch_start(FFPrefetch *p, int64_t seq_no)
+{
+    prefetch_free_desc(p);
+    return AVERROR(ENOSYS);
+}
+
+void ff_prefetch_reset(FFPrefetch *p)
+{
+    prefetch_free_desc(p);
+}
+
+int ff_prefetch_wait(FFPrefetch *p)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_prefetch_read(FFPrefetch *p, uint8_t *buf, int buf_size)
+{
+    return AVERROR_BUG;
+}
+#endif /* HAVE_THREADS */
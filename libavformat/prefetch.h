@@ -0,0 +1,129 @@
+/*
+ * Background download of media segments
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_PREFETCH_H
+#define AVFORMAT_PREFETCH_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/fifo.h"
+#include "libavutil/thread.h"
+#include "avformat.h"
+
+/*
+ * Segments downloaded in the background by the HLS and DASH demuxers.
+ *
+ * Each download runs in its own thread and appends the segment data to a
+ * fifo, from which the demuxer reads when it reaches the segment. The
+ * downloads of a group share a lock and limits on the amount of data they
+ * buffer. A download only waits for the limits while its fifo is not empty,
+ * so the segment being read always makes progress.
+ *
+ * The downloads are opened with an interrupt callback that returns true when
+ * they are reset, or when the interrupt callback of the demuxer does, so a
+ * stalled connection does not block a reset. Custom io_open and io_close
+ * callbacks of the demuxer, and its interrupt callback, are called from the
+ * download threads.
+ */
+
+typedef struct FFPrefetch FFPrefetch;
+
+typedef struct FFPrefetchGroup {
+    AVFormatContext *s;
+    /**
+     * Open the url of p, using p->interrupt_callback.
+     */
+    int (*open)(AVFormatContext *s, FFPrefetch *p, AVIOContext **pb);
+    int64_t max_buffered;   ///< limit on the data buffered by all downloads
+    int64_t max_size;       ///< limit on the data buffered by each download
+
+#if HAVE_THREADS
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int64_t buffered;
+#endif
+} FFPrefetchGroup;
+
+struct FFPrefetch {
+    FFPrefetchGroup *group;
+    /**
+     * Sequence number of the segment, negative if the download is unused.
+     * The fields below up to seg_opts are set by the caller before
+     * ff_prefetch_start() and freed by ff_prefetch_reset().
+     */
+    int64_t seq_no;
+    char *url;
+    int64_t url_offset;
+    int64_t size;           ///< number of bytes to download, -1 for all
+    AVDictionary *opts;     ///< updated with the cookies set by the server
+    AVDictionary *seg_opts;
+
+    AVIOInterruptCB interrupt_callback;
+
+#if HAVE_THREADS
+    pthread_t thread;
+    AVFifoBuffer *fifo;
+    int done;
+    int error;
+    atomic_int abort;
+#endif
+};
+
+int ff_prefetch_group_init(FFPrefetchGroup *g, AVFormatContext *s,
+                           int (*open)(AVFormatContext *s, FFPrefetch *p,
+                                       AVIOContext **pb),
+                           int64_t max_buffered, int64_t max_size);
+
+void ff_prefetch_group_uninit(FFPrefetchGroup *g);
+
+/**
+ * Initialize an unused download of the group.
+ */
+void ff_prefetch_init(FFPrefetch *p, FFPrefetchGroup *g);
+
+/**
+ * Start downloading the segment described by p. On failure, p is reset.
+ */
+int ff_prefetch_start(FFPrefetch *p, int64_t seq_no);
+
+/**
+ * Stop the download, if any, and mark p as unused.
+ */
+void ff_prefetch_reset(FFPrefetch *p);
+
+/**
+ * Wait until the download returned data or ended.
+ *
+ * @return 0 if the segment can be read from p, a negative error code if the
+ *         download failed before returning any data
+ */
+int ff_prefetch_wait(FFPrefetch *p);
+
+/**
+ * Read downloaded data, waiting for it if needed.
+ *
+ * @return the number of bytes read, AVERROR_EOF at the end of the segment,
+ *         or the error that ended the download
+ */
+int ff_prefetch_read(FFPrefetch *p, uint8_t *buf, int buf_size);
+
+#endif /* AVFORMAT_PREFETCH_H */
@@ -0,0 +1,208 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/mem.h"
+#include "libavformat/avformat.h"
+#include "libavformat/prefetch.h"
+
+#define FILE_SIZE   300000
+#define READ_SIZE   1000
+
+static const char *filename;
+static uint8_t data[FILE_SIZE];
+static int interrupted;
+
+static int interrupt_cb(void *opaque)
+{
+    return interrupted;
+}
+
+static int open_cb(AVFormatContext *s, FFPrefetch *p, AVIOContext **pb)
+{
+    AVDictionary *opts = NULL;
+    int ret;
+
+    av_dict_copy(&opts, p->seg_opts, 0);
+    ret = avio_open2(pb, p->url, AVIO_FLAG_READ, &p->interrupt_callback, &opts);
+    av_dict_free(&opts);
+    if (ret >= 0 && p->url_offset)
+        ret = avio_seek(*pb, p->url_offset, SEEK_SET);
+    return ret < 0 ? ret : 0;
+}
+
+static int start(FFPrefetch *p, FFPrefetchGroup *g, int64_t seq_no,
+                 const char *url, int64_t offset, int64_t size)
+{
+    ff_prefetch_init(p, g);
+    p->url        = av_strdup(url);
+    p->url_offset = offset;
+    p->size       = size;
+    if (!p->url)
+        return AVERROR(ENOMEM);
+    return ff_prefetch_start(p, seq_no);
+}
+
+/* Read from p until the end of the segment or until max bytes were read,
+ * and check the data. */
+static int read_all(FFPrefetch *p, int64_t offset, int max)
+{
+    uint8_t buf[READ_SIZE];
+    int pos = 0, ret;
+
+    while (pos < max) {
+        ret = ff_prefetch_read(p, buf, FFMIN(READ_SIZE, max - pos));
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            return ret;
+        if (memcmp(buf, data + offset + pos, ret))
+            return AVERROR_INVALIDDATA;
+        pos += ret;
+    }
+    return pos;
+}
+
+static void report(const char *name, int ret)
+{
+    if (ret < 0)
+        printf("%s: %s\n", name, av_err2str(ret));
+    else
+        printf("%s: %d bytes\n", name, ret);
+}
+
+static int64_t buffered(FFPrefetchGroup *g)
+{
+    int64_t ret;
+
+    pthread_mutex_lock(&g->mutex);
+    ret = g->buffered;
+    pthread_mutex_unlock(&g->mutex);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    AVFormatContext *s;
+    FFPrefetchGroup g = { 0 };
+    FFPrefetch p[2];
+    char url[1024];
+    FILE *f;
+    int i, ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <temporary file>\n", argv[0]);
+        return 1;
+    }
+    filename = argv[1];
+
+    for (i = 0; i < FILE_SIZE; i++)
+        data[i] = i * 7 + (i >> 8);
+    f = fopen(filename, "wb");
+    if (!f || fwrite(data, 1, FILE_SIZE, f) != FILE_SIZE) {
+        fprintf(stderr, "could not write %s\n", filename);
+        if (f)
+            fclose(f);
+        return 1;
+    }
+    fclose(f);
+    snprintf(url, sizeof(url), "file:%s", filename);
+
+    s = avformat_alloc_context();
+    if (!s)
+        return 1;
+    s->interrupt_callback.callback = interrupt_cb;
+
+    /* each download buffers at most 40000 bytes, or 70000 together */
+    ret = ff_prefetch_group_init(&g, s, open_cb, 70000, 40000);
+    if (ret < 0)
+        goto end;
+
+    /* a whole file, and a range of it, while the limits block the threads */
+    ret = start(&p[0], &g, 0, url, 0, -1);
+    if (ret >= 0)
+        ret = ff_prefetch_wait(&p[0]);
+    if (ret >= 0)
+        ret = read_all(&p[0], 0, INT_MAX);
+    report("whole file", ret);
+    ff_prefetch_reset(&p[0]);
+
+    ret = start(&p[0], &g, 1, url, 1234, 56789);
+    if (ret >= 0)
+        ret = read_all(&p[0], 1234, INT_MAX);
+    report("range", ret);
+    ff_prefetch_reset(&p[0]);
+
+    /* a download blocked by the data of the other one still makes progress */
+    ret = start(&p[0], &g, 2, url, 0, -1);
+    if (ret >= 0)
+        ret = start(&p[1], &g, 3, url, 100000, -1);
+    if (ret >= 0)
+        ret = read_all(&p[1], 100000, INT_MAX);
+    report("second download", ret);
+    if (ret >= 0)
+        ret = read_all(&p[0], 0, INT_MAX);
+    report("first download", ret);
+    ff_prefetch_reset(&p[0]);
+    ff_prefetch_reset(&p[1]);
+
+    /* reset while blocked on the limits, with data left in the fifo */
+    ret = start(&p[0], &g, 4, url, 0, -1);
+    if (ret >= 0)
+        ret = read_all(&p[0], 0, 5000);
+    report("partial read", ret);
+    ff_prefetch_reset(&p[0]);
+    printf("buffered after reset: %"PRId64"\n", buffered(&g));
+
+    /* reset while blocked on IO, waiting for the file to grow */
+    ff_prefetch_init(&p[0], &g);
+    p[0].url  = av_strdup(url);
+    p[0].size = -1;
+    av_dict_set(&p[0].seg_opts, "follow", "1", 0);
+    ret = ff_prefetch_start(&p[0], 5);
+    if (ret >= 0)
+        ret = read_all(&p[0], 0, FILE_SIZE);
+    report("growing file", ret);
+    ff_prefetch_reset(&p[0]);
+    printf("buffered after reset: %"PRId64"\n", buffered(&g));
+
+    /* failures are reported by the reads */
+    snprintf(url, sizeof(url), "file:%s.missing", filename);
+    ret = start(&p[0], &g, 6, url, 0, -1);
+    if (ret >= 0)
+        ret = ff_prefetch_wait(&p[0]);
+    report("missing file", ret);
+    ff_prefetch_reset(&p[0]);
+
+    snprintf(url, sizeof(url), "file:%s", filename);
+    interrupted = 1;
+    ret = start(&p[0], &g, 7, url, 0, -1);
+    if (ret >= 0)
+        ret = read_all(&p[0], 0, INT_MAX);
+    report("interrupted", ret);
+    ff_prefetch_reset(&p[0]);
+    ret = 0;
+
+end:
+    ff_prefetch_group_uninit(&g);
+    avformat_free_context(s);
+    remove(filename);
+    return ret < 0;
+}
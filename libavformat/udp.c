@@ -26,6 +26,7 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() */
 
 #include "avformat.h"
 #include "avio_internal.h"
@@ -79,6 +80,9 @@
 #define UDP_RX_BUF_SIZE 393216
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+/* Number of datagrams received or sent with one recvmmsg()/sendmmsg() call */
+#define UDP_BATCH_SIZE 16
+#define UDP_BATCH_SLOT_SIZE (UDP_MAX_PKT_SIZE + 4)
 
 typedef struct UDPContext {
     const AVClass *class;
@@ -110,6 +114,21 @@ typedef struct UDPContext {
     int thread_started;
 #endif
     uint8_t tmp[UDP_MAX_PKT_SIZE+4];
+    /* Datagrams handled together by the circular buffer thread, each one
+     * stored after its 4 byte size every UDP_BATCH_SLOT_SIZE bytes. Unset if
+     * the thread handles one datagram at a time in tmp. */
+    uint8_t *batch_buf;
+    int batch_len[UDP_BATCH_SIZE];
+    struct sockaddr_storage batch_addrs[UDP_BATCH_SIZE];
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    struct mmsghdr batch_msgs[UDP_BATCH_SIZE];
+    struct iovec batch_iov[UDP_BATCH_SIZE];
+#endif
+#if HAVE_RECVMMSG && defined(SO_RXQ_OVFL)
+    uint8_t batch_cmsg[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(uint32_t))];
+#endif
+    int64_t dropped_packets;
+    int64_t socket_dropped_packets;
     int remaining_in_dg;
     char *localaddr;
     int timeout;
@@ -141,6 +160,8 @@ static const AVOption options[] = {
     { "timeout",        "set raise error timeout, in microseconds (only in read mode)",OFFSET(timeout),         AV_OPT_TYPE_INT,  {.i64 = 0}, 0, INT_MAX, D },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
+    { "dropped_packets", "export the number of datagrams dropped because the circular buffer was full", OFFSET(dropped_packets), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
+    { "socket_dropped_packets", "export the number of datagrams dropped by the system because the socket buffer was full", OFFSET(socket_dropped_packets), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
     { NULL }
 };
 
@@ -460,6 +481,66 @@ static int udp_get_file_handle(URLContext *h)
 }
 
 #if HAVE_PTHREAD_CANCEL
+/* Return the buffer of the i-th datagram of a batch, preceded by its size. */
+static uint8_t *udp_batch_pkt(UDPContext *s, int i)
+{
+    return s->batch_buf ? s->batch_buf + i * UDP_BATCH_SLOT_SIZE : s->tmp;
+}
+
+/**
+ * Receive at least one datagram, and with recvmmsg() up to UDP_BATCH_SIZE
+ * of those already queued on the socket, into the batch.
+ *
+ * @return the number of datagrams received or a negative error code
+ */
+static int udp_recv_batch(UDPContext *s)
+{
+#if HAVE_RECVMMSG
+    if (s->batch_buf) {
+        int i, n;
+
+        for (i = 0; i < UDP_BATCH_SIZE; i++) {
+            struct msghdr *msg = &s->batch_msgs[i].msg_hdr;
+            s->batch_iov[i].iov_base = udp_batch_pkt(s, i) + 4;
+            s->batch_iov[i].iov_len  = UDP_MAX_PKT_SIZE;
+            memset(msg, 0, sizeof(*msg));
+            msg->msg_name    = &s->batch_addrs[i];
+            msg->msg_namelen = sizeof(s->batch_addrs[i]);
+            msg->msg_iov     = &s->batch_iov[i];
+            msg->msg_iovlen  = 1;
+#ifdef SO_RXQ_OVFL
+            msg->msg_control    = s->batch_cmsg[i];
+            msg->msg_controllen = sizeof(s->batch_cmsg[i]);
+#endif
+        }
+        n = recvmmsg(s->udp_fd, s->batch_msgs, UDP_BATCH_SIZE, MSG_WAITFORONE, NULL);
+        if (n < 0)
+            return ff_neterrno();
+        for (i = 0; i < n; i++) {
+#ifdef SO_RXQ_OVFL
+            struct msghdr *msg = &s->batch_msgs[i].msg_hdr;
+            struct cmsghdr *cmsg;
+            for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+                /* the socket drop count, only sent once it is not zero */
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+                    s->socket_dropped_packets = AV_RN32(CMSG_DATA(cmsg));
+            }
+#endif
+            s->batch_len[i] = s->batch_msgs[i].msg_len;
+        }
+        return n;
+    }
+#endif
+    {
+        socklen_t addr_len = sizeof(s->batch_addrs[0]);
+        int len = recvfrom(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0, (struct sockaddr *)&s->batch_addrs[0], &addr_len);
+        if (len < 0)
+            return ff_neterrno();
+        s->batch_len[0] = len;
+        return 1;
+    }
+}
+
 static void *circular_buffer_task_rx( void *_URLContext)
 {
     URLContext *h = _URLContext;
@@ -474,45 +555,51 @@ static void *circular_buffer_task_rx( void *_URLContext)
         goto end;
     }
     while(1) {
-        int len;
-        struct sockaddr_storage addr;
-        socklen_t addr_len = sizeof(addr);
+        int i, n, written = 0;
 
         pthread_mutex_unlock(&s->mutex);
         /* Blocking operations are always cancellation points;
            see "General Information" / "Thread Cancelation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-        len = recvfrom(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0, (struct sockaddr *)&addr, &addr_len);
+        n = udp_recv_batch(s);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
         pthread_mutex_lock(&s->mutex);
-        if (len < 0) {
-            if (ff_neterrno() != AVERROR(EAGAIN) && ff_neterrno() != AVERROR(EINTR)) {
-                s->circular_buffer_error = ff_neterrno();
+        if (n < 0) {
+            if (n != AVERROR(EAGAIN) && n != AVERROR(EINTR)) {
+                s->circular_buffer_error = n;
                 goto end;
             }
             continue;
         }
-        if (ff_ip_check_source_lists(&addr, &s->filters))
-            continue;
-        AV_WL32(s->tmp, len);
+        for (i = 0; i < n; i++) {
+            uint8_t *pkt = udp_batch_pkt(s, i);
+            int len = s->batch_len[i];
 
-        if(av_fifo_space(s->fifo) < len + 4) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
+            if (ff_ip_check_source_lists(&s->batch_addrs[i], &s->filters))
                 continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+            AV_WL32(pkt, len);
+
+            if(av_fifo_space(s->fifo) < len + 4) {
+                /* No Space left */
+                if (s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                            "Surviving due to overrun_nonfatal option\n");
+                    s->dropped_packets++;
+                    continue;
+                } else {
+                    av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                            "To avoid, increase fifo_size URL option. "
+                            "To survive in such case, use overrun_nonfatal option\n");
+                    s->circular_buffer_error = AVERROR(EIO);
+                    goto end;
+                }
             }
+            av_fifo_generic_write(s->fifo, pkt, len+4, NULL);
+            written = 1;
         }
-        av_fifo_generic_write(s->fifo, s->tmp, len+4, NULL);
-        pthread_cond_signal(&s->cond);
+        if (written)
+            pthread_cond_signal(&s->cond);
     }
 
 end:
@@ -521,6 +608,70 @@ end:
     return NULL;
 }
 
+/**
+ * Send the first nb datagrams of the batch, with one sendmmsg() call if
+ * possible.
+ *
+ * @return 0 or a negative error code
+ */
+static int udp_send_batch(UDPContext *s, int nb)
+{
+    int i = 0;
+
+#if HAVE_SENDMMSG
+    if (s->batch_buf) {
+        for (i = 0; i < nb; i++) {
+            struct msghdr *msg = &s->batch_msgs[i].msg_hdr;
+            s->batch_iov[i].iov_base = udp_batch_pkt(s, i) + 4;
+            s->batch_iov[i].iov_len  = s->batch_len[i];
+            memset(msg, 0, sizeof(*msg));
+            if (!s->is_connected) {
+                msg->msg_name    = &s->dest_addr;
+                msg->msg_namelen = s->dest_addr_len;
+            }
+            msg->msg_iov    = &s->batch_iov[i];
+            msg->msg_iovlen = 1;
+        }
+        i = 0;
+        while (i < nb) {
+            int ret = sendmmsg(s->udp_fd, s->batch_msgs + i, nb - i, 0);
+            if (ret >= 0) {
+                i += ret;
+            } else {
+                ret = ff_neterrno();
+                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                    return ret;
+            }
+        }
+        return 0;
+    }
+#endif
+    for (i = 0; i < nb; i++) {
+        const uint8_t *p = udp_batch_pkt(s, i) + 4;
+        int len = s->batch_len[i];
+
+        while (len) {
+            int ret;
+            av_assert0(len > 0);
+            if (!s->is_connected) {
+                ret = sendto (s->udp_fd, p, len, 0,
+                            (struct sockaddr *) &s->dest_addr,
+                            s->dest_addr_len);
+            } else
+                ret = send(s->udp_fd, p, len, 0);
+            if (ret >= 0) {
+                len -= ret;
+                p   += ret;
+            } else {
+                ret = ff_neterrno();
+                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                    return ret;
+            }
+        }
+    }
+    return 0;
+}
+
 static void *circular_buffer_task_tx( void *_URLContext)
 {
     URLContext *h = _URLContext;
@@ -530,6 +681,7 @@ static void *circular_buffer_task_tx( void *_URLContext)
     int64_t sent_bits = 0;
     int64_t burst_interval = s->bitrate ? (s->burst_bits * 1000000 / s->bitrate) : 0;
     int64_t max_delay = s->bitrate ?  ((int64_t)h->max_packet_size * 8 * 1000000 / s->bitrate + 1) : 0;
+    int nb = 0, max_nb = s->batch_buf ? UDP_BATCH_SIZE : 1, ret;
 
     pthread_mutex_lock(&s->mutex);
 
@@ -541,7 +693,6 @@ static void *circular_buffer_task_tx( void *_URLContext)
 
     for(;;) {
         int len;
-        const uint8_t *p;
         uint8_t tmp[4];
         int64_t timestamp;
 
@@ -560,9 +711,10 @@ static void *circular_buffer_task_tx( void *_URLContext)
         len = AV_RL32(tmp);
 
         av_assert0(len >= 0);
-        av_assert0(len <= sizeof(s->tmp));
+        av_assert0(len <= sizeof(s->tmp) - 4);
 
-        av_fifo_generic_read(s->fifo, s->tmp, len, NULL);
+        av_fifo_generic_read(s->fifo, udp_batch_pkt(s, nb) + 4, len, NULL);
+        s->batch_len[nb] = len;
 
         pthread_mutex_unlock(&s->mutex);
 
@@ -575,6 +727,15 @@ static void *circular_buffer_task_tx( void *_URLContext)
                     start_timestamp = timestamp + delay;
                     sent_bits = 0;
                 }
+                /* the datagrams already in the batch are due now */
+                if (nb) {
+                    ret = udp_send_batch(s, nb);
+                    if (ret < 0)
+                        goto fail;
+                    memcpy(udp_batch_pkt(s, 0) + 4, udp_batch_pkt(s, nb) + 4, len);
+                    s->batch_len[0] = len;
+                    nb = 0;
+                }
                 av_usleep(delay);
             } else {
                 if (timestamp - burst_interval > target_timestamp) {
@@ -585,37 +746,29 @@ static void *circular_buffer_task_tx( void *_URLContext)
             sent_bits += len * 8;
             target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
         }
+        nb++;
 
-        p = s->tmp;
-        while (len) {
-            int ret;
-            av_assert0(len > 0);
-            if (!s->is_connected) {
-                ret = sendto (s->udp_fd, p, len, 0,
-                            (struct sockaddr *) &s->dest_addr,
-                            s->dest_addr_len);
-            } else
-                ret = send(s->udp_fd, p, len, 0);
-            if (ret >= 0) {
-                len -= ret;
-                p   += ret;
-            } else {
-                ret = ff_neterrno();
-                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR)) {
-                    pthread_mutex_lock(&s->mutex);
-                    s->circular_buffer_error = ret;
-                    pthread_mutex_unlock(&s->mutex);
-                    return NULL;
-                }
-            }
-        }
-
+        /* send once the batch is full or no other datagram is queued */
         pthread_mutex_lock(&s->mutex);
+        if (nb == max_nb || av_fifo_size(s->fifo) < 4) {
+            pthread_mutex_unlock(&s->mutex);
+            ret = udp_send_batch(s, nb);
+            if (ret < 0)
+                goto fail;
+            nb = 0;
+            pthread_mutex_lock(&s->mutex);
+        }
     }
 
 end:
     pthread_mutex_unlock(&s->mutex);
     return NULL;
+
+fail:
+    pthread_mutex_lock(&s->mutex);
+    s->circular_buffer_error = ret;
+    pthread_mutex_unlock(&s->mutex);
+    return NULL;
 }
 
 
@@ -911,6 +1064,18 @@ static int udp_open(URLContext *h, const char *uri, int flags)
             ret = AVERROR(ENOMEM);
             goto fail;
         }
+        if (is_output ? HAVE_SENDMMSG : HAVE_RECVMMSG) {
+            s->batch_buf = av_malloc(UDP_BATCH_SIZE * UDP_BATCH_SLOT_SIZE);
+            if (!s->batch_buf) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+#ifdef SO_RXQ_OVFL
+            tmp = 1;
+            if (!is_output && setsockopt(udp_fd, SOL_SOCKET, SO_RXQ_OVFL, &tmp, sizeof(tmp)) < 0)
+                ff_log_net_error(h, AV_LOG_DEBUG, "setsockopt(SO_RXQ_OVFL)");
+#endif
+        }
         ret = pthread_mutex_init(&s->mutex, NULL);
         if (ret != 0) {
             av_log(h, AV_LOG_ERROR, "pthread_mutex_init failed : %s\n", strerror(ret));
@@ -944,6 +1109,7 @@ static int udp_open(URLContext *h, const char *uri, int flags)
     if (udp_fd >= 0)
         closesocket(udp_fd);
     av_fifo_freep(&s->fifo);
+    av_freep(&s->batch_buf);
     ff_ip_reset_filters(&s->filters);
     return ret;
 }
@@ -1112,6 +1278,7 @@ static int udp_close(URLContext *h)
 #endif
     closesocket(s->udp_fd);
     av_fifo_freep(&s->fifo);
+    av_freep(&s->batch_buf);
     ff_ip_reset_filters(&s->filters);
     return 0;
 }
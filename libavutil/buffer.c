@@ -16,9 +16,20 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _GNU_SOURCE // getcpu(), MAP_ANONYMOUS, madvise()
+
+#include "config.h"
+
 #include <stdatomic.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#if HAVE_GETCPU
+#include <sched.h>
+#endif
 
 #include "avassert.h"
 #include "buffer_internal.h"
@@ -26,6 +37,14 @@
 #include "mem.h"
 #include "thread.h"
 
+#if HAVE_MMAP && HAVE_MADVISE && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+#define HAVE_HUGE_PAGES 1
+#else
+#define HAVE_HUGE_PAGES 0
+#endif
+
+static atomic_int pool_default_flags = ATOMIC_VAR_INIT(0);
+
 AVBufferRef *av_buffer_create(uint8_t *data, buffer_size_t size,
                               void (*free)(void *opaque, uint8_t *data),
                               void *opaque, int flags)
@@ -242,6 +261,15 @@ int av_buffer_replace(AVBufferRef **pdst, AVBufferRef *src)
     return 0;
 }
 
+static void pool_init_common(AVBufferPool *pool)
+{
+    int i;
+
+    atomic_init(&pool->refcount, 1);
+    for (i = 0; i < POOL_MAX_NODES; i++)
+        atomic_init(&pool->free_list[i], POOL_INDEX_NONE);
+}
+
 AVBufferPool *av_buffer_pool_init2(buffer_size_t size, void *opaque,
                                    AVBufferRef* (*alloc)(void *opaque, buffer_size_t size),
                                    void (*pool_free)(void *opaque))
@@ -258,7 +286,7 @@ AVBufferPool *av_buffer_pool_init2(buffer_size_t size, void *opaque,
     pool->alloc     = av_buffer_alloc; // fallback
     pool->pool_free = pool_free;
 
-    atomic_init(&pool->refcount, 1);
+    pool_init_common(pool);
 
     return pool;
 }
@@ -274,19 +302,81 @@ AVBufferPool *av_buffer_pool_init(buffer_size_t size, AVBufferRef* (*alloc)(buff
     pool->size     = size;
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
 
-    atomic_init(&pool->refcount, 1);
+    pool_init_common(pool);
+
+    /* custom allocators may depend on how their buffers are allocated */
+    if (pool->alloc == av_buffer_alloc || pool->alloc == av_buffer_allocz)
+        pool->flags = atomic_load_explicit(&pool_default_flags,
+                                           memory_order_relaxed);
 
     return pool;
 }
 
+static BufferPoolEntry *pool_entry(AVBufferPool *pool, uintptr_t index)
+{
+    int segment = av_log2((index >> POOL_SEGMENT_BITS) + 1);
+    return &pool->segments[segment][index + POOL_SEGMENT_SIZE -
+                                    ((uintptr_t)POOL_SEGMENT_SIZE << segment)];
+}
+
+static void pool_push(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    atomic_uintptr_t *free_list = &pool->free_list[buf->node];
+    uintptr_t head = atomic_load_explicit(free_list, memory_order_relaxed);
+    uintptr_t new_head;
+
+    do {
+        atomic_store_explicit(&buf->next, head & POOL_INDEX_MASK, memory_order_relaxed);
+        new_head = ((head & ~POOL_INDEX_MASK) + POOL_INDEX_MASK + 1) | buf->index;
+    } while (!atomic_compare_exchange_weak_explicit(free_list, &head, new_head,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+static BufferPoolEntry *pool_pop(AVBufferPool *pool, int node)
+{
+    atomic_uintptr_t *free_list = &pool->free_list[node];
+    uintptr_t head = atomic_load_explicit(free_list, memory_order_acquire);
+    uintptr_t new_head;
+    BufferPoolEntry *buf;
+
+    do {
+        if ((head & POOL_INDEX_MASK) == POOL_INDEX_NONE)
+            return NULL;
+        buf      = pool_entry(pool, head & POOL_INDEX_MASK);
+        new_head = ((head & ~POOL_INDEX_MASK) + POOL_INDEX_MASK + 1) |
+                   atomic_load_explicit(&buf->next, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(free_list, &head, new_head,
+                                                    memory_order_acquire,
+                                                    memory_order_acquire));
+
+    return buf;
+}
+
+/* free list to use for the calling thread */
+static int pool_node(AVBufferPool *pool)
+{
+#if HAVE_GETCPU
+    if (pool->flags & AV_BUFFER_POOL_FLAG_NUMA_LOCAL) {
+        unsigned cpu, node;
+        if (!getcpu(&cpu, &node))
+            return node % POOL_MAX_NODES;
+    }
+#endif
+    return 0;
+}
+
 static void buffer_pool_flush(AVBufferPool *pool)
 {
-    while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
-        pool->pool = buf->next;
+    BufferPoolEntry *buf;
+    int i;
 
-        buf->free(buf->opaque, buf->data);
-        av_freep(&buf);
+    /* the entries stay allocated until the pool is freed */
+    for (i = 0; i < POOL_MAX_NODES; i++) {
+        while ((buf = pool_pop(pool, i))) {
+            buf->free(buf->opaque, buf->data);
+            buf->data = NULL;
+        }
     }
 }
 
@@ -296,9 +386,14 @@ static void buffer_pool_flush(AVBufferPool *pool)
  */
 static void buffer_pool_free(AVBufferPool *pool)
 {
+    int i;
+
     buffer_pool_flush(pool);
     ff_mutex_destroy(&pool->mutex);
 
+    for (i = 0; i < POOL_MAX_SEGMENTS; i++)
+        av_freep(&pool->segments[i]);
+
     if (pool->pool_free)
         pool->pool_free(pool->opaque);
 
@@ -314,9 +409,7 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
     pool   = *ppool;
     *ppool = NULL;
 
-    ff_mutex_lock(&pool->mutex);
     buffer_pool_flush(pool);
-    ff_mutex_unlock(&pool->mutex);
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -330,43 +423,160 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     if(CONFIG_MEMORY_POISONING)
         memset(buf->data, FF_MEMORY_POISON, pool->size);
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    pool_push(pool, buf);
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
 }
 
+/* get a free entry, allocating a new segment if needed; called with the
+ * pool mutex held */
+static BufferPoolEntry *pool_alloc_entry(AVBufferPool *pool)
+{
+    uintptr_t index = pool->nb_entries;
+    int segment;
+    BufferPoolEntry *buf;
+
+    if (index >= ((uintptr_t)POOL_SEGMENT_SIZE << POOL_MAX_SEGMENTS) - POOL_SEGMENT_SIZE)
+        return NULL;
+
+    segment = av_log2((index >> POOL_SEGMENT_BITS) + 1);
+    if (!pool->segments[segment]) {
+        pool->segments[segment] = av_calloc((size_t)POOL_SEGMENT_SIZE << segment,
+                                            sizeof(*pool->segments[segment]));
+        if (!pool->segments[segment])
+            return NULL;
+    }
+
+    buf        = pool_entry(pool, index);
+    buf->index = index;
+    pool->nb_entries++;
+
+    return buf;
+}
+
+#if HAVE_HUGE_PAGES
+static size_t huge_page_size = 2 << 20;
+static AVOnce huge_page_size_once = AV_ONCE_INIT;
+
+/* The default size of the explicit huge pages. Transparent huge pages have
+ * the same size on the usual configurations. */
+static void huge_page_size_init(void)
+{
+    FILE *f = fopen("/proc/meminfo", "r");
+    unsigned long kb;
+    char line[128];
+
+    if (!f)
+        return;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+            if (kb && !(kb & (kb - 1)) && kb <= INT_MAX / 1024)
+                huge_page_size = kb * 1024;
+            break;
+        }
+    }
+    fclose(f);
+}
+
+static void huge_page_free(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+/* map size bytes backed by huge pages: explicit ones if the system has
+ * reserved some, transparent huge pages otherwise */
+static AVBufferRef *huge_page_alloc(size_t size)
+{
+    AVBufferRef *ret;
+    uint8_t *data, *aligned;
+    size_t len = FFALIGN(size, huge_page_size);
+
+    if (len > INT_MAX)
+        return NULL;
+
+#ifdef MAP_HUGETLB
+    data = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED)
+        goto done;
+#endif
+
+    /* over-map so that the mapping can be trimmed to a huge page boundary */
+    data = mmap(NULL, len + huge_page_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    aligned = (uint8_t *)FFALIGN((uintptr_t)data, huge_page_size);
+    if (aligned > data)
+        munmap(data, aligned - data);
+    if (aligned + len < data + len + huge_page_size)
+        munmap(aligned + len, data + len + huge_page_size - (aligned + len));
+    data = aligned;
+
+    madvise(data, len, MADV_HUGEPAGE);
+
+done:
+    ret = av_buffer_create(data, size, huge_page_free, (void *)(uintptr_t)len, 0);
+    if (!ret)
+        munmap(data, len);
+    return ret;
+}
+#endif
+
+static AVBufferRef *pool_alloc_data(AVBufferPool *pool)
+{
+    if (pool->alloc2)
+        return pool->alloc2(pool->opaque, pool->size);
+
+#if HAVE_HUGE_PAGES
+    /* mmap()ed memory is zeroed, so this also covers av_buffer_allocz() */
+    if ((pool->flags & AV_BUFFER_POOL_FLAG_HUGE_PAGES) &&
+        !ff_thread_once(&huge_page_size_once, huge_page_size_init) &&
+        pool->size >= huge_page_size &&
+        (pool->alloc == av_buffer_alloc || pool->alloc == av_buffer_allocz)) {
+        AVBufferRef *ret = huge_page_alloc(pool->size);
+        if (ret)
+            return ret;
+    }
+#endif
+
+    return pool->alloc(pool->size);
+}
+
 /* allocate a new buffer and override its free() callback so that
  * it is returned to the pool on free */
-static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
+static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool, int node)
 {
     BufferPoolEntry *buf;
     AVBufferRef     *ret;
 
     av_assert0(pool->alloc || pool->alloc2);
 
-    ret = pool->alloc2 ? pool->alloc2(pool->opaque, pool->size) :
-                         pool->alloc(pool->size);
+    ff_mutex_lock(&pool->mutex);
+
+    ret = pool_alloc_data(pool);
     if (!ret)
-        return NULL;
+        goto end;
 
-    buf = av_mallocz(sizeof(*buf));
+    buf = pool_alloc_entry(pool);
     if (!buf) {
         av_buffer_unref(&ret);
-        return NULL;
+        goto end;
     }
 
     buf->data   = ret->buffer->data;
     buf->opaque = ret->buffer->opaque;
     buf->free   = ret->buffer->free;
     buf->pool   = pool;
+    buf->node   = node;
 
     ret->buffer->opaque = buf;
     ret->buffer->free   = pool_release_buffer;
 
+end:
+    ff_mutex_unlock(&pool->mutex);
     return ret;
 }
 
@@ -374,20 +584,23 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
     AVBufferRef *ret;
     BufferPoolEntry *buf;
-
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
+    int node = pool_node(pool), i;
+
+    buf = pool_pop(pool, node);
+    /* take the buffers released on the other nodes before allocating, so that
+     * the pool does not grow as threads migrate, and pools which cannot
+     * allocate more buffers still hand out the ones they have */
+    if (pool->flags & AV_BUFFER_POOL_FLAG_NUMA_LOCAL)
+        for (i = 1; !buf && i < POOL_MAX_NODES; i++)
+            buf = pool_pop(pool, (node + i) % POOL_MAX_NODES);
     if (buf) {
         ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
                                buf, 0);
-        if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
-        }
+        if (!ret)
+            pool_push(pool, buf);
     } else {
-        ret = pool_alloc_buffer(pool);
+        ret = pool_alloc_buffer(pool, node);
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
@@ -395,6 +608,16 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     return ret;
 }
 
+void av_buffer_pool_set_flags(AVBufferPool *pool, int flags)
+{
+    pool->flags = flags;
+}
+
+void av_buffer_pool_set_default_flags(int flags)
+{
+    atomic_store_explicit(&pool_default_flags, flags, memory_order_relaxed);
+}
+
 void *av_buffer_pool_buffer_get_opaque(AVBufferRef *ref)
 {
     BufferPoolEntry *buf = ref->buffer->opaque;
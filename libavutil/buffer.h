@@ -346,6 +346,46 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool);
  */
 void *av_buffer_pool_buffer_get_opaque(AVBufferRef *ref);
 
+/**
+ * Back the buffers of the pool with huge pages when they are at least as
+ * large as a huge page (the Hugepagesize of the system, usually 2 MiB), using
+ * explicit huge pages if the system has some reserved and transparent huge
+ * pages otherwise. Reduces the TLB misses when processing large video frames.
+ */
+#define AV_BUFFER_POOL_FLAG_HUGE_PAGES (1 << 0)
+
+/**
+ * Keep a separate list of available buffers for each NUMA node, so that a
+ * thread gets buffers which were first used, and therefore allocated, on the
+ * node it runs on. A thread takes the buffers available on the other nodes
+ * before allocating a new one.
+ */
+#define AV_BUFFER_POOL_FLAG_NUMA_LOCAL (1 << 1)
+
+/**
+ * Set the flags of a pool. AV_BUFFER_POOL_FLAG_HUGE_PAGES only applies to
+ * pools using the default allocators (av_buffer_alloc() or
+ * av_buffer_allocz()). Flags not supported by the system are ignored.
+ *
+ * Must be called before the first call to av_buffer_pool_get().
+ *
+ * @param pool  the pool
+ * @param flags a combination of AV_BUFFER_POOL_FLAG_*
+ */
+void av_buffer_pool_set_flags(AVBufferPool *pool, int flags);
+
+/**
+ * Set the flags given to the pools created afterwards with
+ * av_buffer_pool_init() and the default allocators (NULL, av_buffer_alloc()
+ * or av_buffer_allocz()), including the frame pools of the other FFmpeg
+ * libraries. Pools with custom allocators, or created with
+ * av_buffer_pool_init2(), only get flags from av_buffer_pool_set_flags().
+ * The default is 0.
+ *
+ * @param flags a combination of AV_BUFFER_POOL_FLAG_*
+ */
+void av_buffer_pool_set_default_flags(int flags);
+
 /**
  * @}
  */
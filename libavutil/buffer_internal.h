@@ -72,12 +72,54 @@ typedef struct BufferPoolEntry {
     void (*free)(void *opaque, uint8_t *data);
 
     AVBufferPool *pool;
-    struct BufferPoolEntry *next;
+
+    /*
+     * Index of this entry, and of the next one in the free list while the
+     * entry is in it.
+     */
+    uintptr_t index;
+    atomic_uintptr_t next;
+
+    /* free list the entry is returned to */
+    int node;
 } BufferPoolEntry;
 
+/*
+ * The entries are allocated in segments which are never moved, segment s
+ * holding POOL_SEGMENT_SIZE << s entries, so that the entries can be
+ * referred to by their index in the free list.
+ */
+#define POOL_SEGMENT_BITS 4
+#define POOL_SEGMENT_SIZE (1 << POOL_SEGMENT_BITS)
+#define POOL_INDEX_BITS   (sizeof(uintptr_t) * 4)
+#define POOL_INDEX_MASK   (UINTPTR_MAX >> (sizeof(uintptr_t) * 8 - POOL_INDEX_BITS))
+#define POOL_INDEX_NONE   POOL_INDEX_MASK
+#define POOL_MAX_SEGMENTS (POOL_INDEX_BITS - POOL_SEGMENT_BITS)
+
+/* number of free lists used with AV_BUFFER_POOL_FLAG_NUMA_LOCAL */
+#define POOL_MAX_NODES    8
+
 struct AVBufferPool {
+    /*
+     * Serializes the allocation of new buffers; getting and releasing pooled
+     * buffers does not need it.
+     */
     AVMutex mutex;
-    BufferPoolEntry *pool;
+
+    /*
+     * Lock-free stack of the buffers available for reuse: the low
+     * POOL_INDEX_BITS bits hold the index of the top entry, or
+     * POOL_INDEX_NONE, the high bits a counter incremented by every update.
+     * The counter makes a pop fail when other threads popped the top entry
+     * and pushed it back in the meantime, as its next entry may have changed.
+     *
+     * There is one list per NUMA node with AV_BUFFER_POOL_FLAG_NUMA_LOCAL,
+     * only the first one is used otherwise.
+     */
+    atomic_uintptr_t free_list[POOL_MAX_NODES];
+
+    BufferPoolEntry *segments[POOL_MAX_SEGMENTS];
+    uintptr_t nb_entries;
 
     /*
      * This is used to track when the pool is to be freed.
@@ -95,6 +137,9 @@ struct AVBufferPool {
     AVBufferRef* (*alloc)(buffer_size_t size);
     AVBufferRef* (*alloc2)(void *opaque, buffer_size_t size);
     void         (*pool_free)(void *opaque);
+
+    /* AV_BUFFER_POOL_FLAG_* */
+    int flags;
 };
 
 #endif /* AVUTIL_BUFFER_INTERNAL_H */
@@ -0,0 +1,170 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program gets and releases buffers from a pool shared by several
+ * threads, checks that no buffer is handed out twice at the same time, and
+ * prints the get/release throughput for each number of threads.
+ *
+ * The whole buffer is written each time it is got, so with a large size
+ * (e.g. 50331648 for an 8K 4:2:0 16-bit frame) it also measures the cost of
+ * touching the memory, and pool flags can be given to compare allocations.
+ *
+ * It also checks that a pool which cannot allocate more than NB_HELD buffers
+ * keeps handing out the ones released, with the given flags.
+ *
+ * Usage: buffer_pool [max_threads [iterations [size [flags]]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define CHECK_SIZE 64
+#define NB_HELD    4
+
+typedef struct ThreadData {
+    AVBufferPool *pool;
+    int size;
+    int id;
+    int iterations;
+    int errors;
+} ThreadData;
+
+static void *thread_main(void *arg)
+{
+    ThreadData *td = arg;
+    AVBufferRef *held[NB_HELD] = { NULL };
+    int i, j;
+
+    for (i = 0; i < td->iterations; i++) {
+        AVBufferRef **buf = &held[i % NB_HELD];
+
+        if (*buf) {
+            for (j = 0; j < CHECK_SIZE; j++)
+                if ((*buf)->data[j] != (uint8_t)(td->id + i % NB_HELD))
+                    td->errors++;
+            av_buffer_unref(buf);
+        }
+
+        *buf = av_buffer_pool_get(td->pool);
+        if (!*buf) {
+            td->errors++;
+            break;
+        }
+        memset((*buf)->data, td->id + i % NB_HELD, td->size);
+    }
+
+    for (i = 0; i < NB_HELD; i++)
+        av_buffer_unref(&held[i]);
+    return NULL;
+}
+
+static AVBufferRef *fixed_alloc(void *opaque, buffer_size_t size)
+{
+    int *nb_allocated = opaque;
+
+    if (*nb_allocated >= NB_HELD)
+        return NULL;
+    (*nb_allocated)++;
+    return av_buffer_alloc(size);
+}
+
+static int check_fixed_pool(int flags)
+{
+    AVBufferRef *held[NB_HELD];
+    AVBufferPool *pool;
+    int nb_allocated = 0, errors = 0, i, j;
+
+    pool = av_buffer_pool_init2(CHECK_SIZE, &nb_allocated, fixed_alloc, NULL);
+    if (!pool)
+        return 1;
+    av_buffer_pool_set_flags(pool, flags);
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < NB_HELD; j++)
+            if (!(held[j] = av_buffer_pool_get(pool)))
+                errors++;
+        for (j = 0; j < NB_HELD; j++)
+            av_buffer_unref(&held[j]);
+    }
+
+    av_buffer_pool_uninit(&pool);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+    int iterations  = argc > 2 ? atoi(argv[2]) : 100000;
+    int size        = argc > 3 ? atoi(argv[3]) : CHECK_SIZE;
+    int flags       = argc > 4 ? atoi(argv[4]) : 0;
+    ThreadData td[64];
+    pthread_t threads[64];
+    int nb_threads, i, ret, errors = 0;
+
+    max_threads = av_clip(max_threads, 1, FF_ARRAY_ELEMS(threads));
+    size        = FFMAX(size, CHECK_SIZE);
+
+    for (nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+        AVBufferPool *pool = av_buffer_pool_init(size, NULL);
+        int64_t start, elapsed;
+
+        if (!pool)
+            return 1;
+        av_buffer_pool_set_flags(pool, flags);
+
+        start = av_gettime_relative();
+        for (i = 0; i < nb_threads; i++) {
+            td[i].pool       = pool;
+            td[i].size       = size;
+            td[i].id         = i * NB_HELD;
+            td[i].iterations = iterations;
+            td[i].errors     = 0;
+            if ((ret = pthread_create(&threads[i], NULL, thread_main, &td[i]))) {
+                fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+                return 1;
+            }
+        }
+        for (i = 0; i < nb_threads; i++) {
+            pthread_join(threads[i], NULL);
+            errors += td[i].errors;
+        }
+
+        elapsed = FFMAX(av_gettime_relative() - start, 1);
+        printf("%2d threads: %6.2f Mops/s %8.1f MB/s\n", nb_threads,
+               (double)nb_threads * iterations / elapsed,
+               (double)nb_threads * iterations * size / elapsed);
+
+        av_buffer_pool_uninit(&pool);
+    }
+
+    errors += check_fixed_pool(flags);
+
+    if (errors) {
+        fprintf(stderr, "%d errors\n", errors);
+        return 2;
+    }
+    return 0;
+}
@@ -235,9 +235,15 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+/**
+ * Scale an input slice into dst. If dstSliceH is not 0, the whole source
+ * image must be passed and only the output lines dstSliceY to
+ * dstSliceY + dstSliceH - 1 are written, starting from a clean state.
+ */
+static int swscale_internal(SwsContext *c, const uint8_t *src[],
+                            int srcStride[], int srcSliceY,
+                            int srcSliceH, uint8_t *dst[], int dstStride[],
+                            int dstSliceY, int dstSliceH)
 {
     /* load a few things into local vars to make the code more readable?
      * and faster */
@@ -264,6 +270,8 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     int should_dither                = isNBPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
     int lastDstY;
+    int dstEnd                       = dstH;
+    const int dstLines               = dstSliceH ? dstSliceH : dstH;
 
     /* vars which will change and which we need to store back in the context */
     int dstY         = c->dstY;
@@ -334,7 +342,12 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     /* Note the user might start scaling the picture in the middle so this
      * will not get executed. This is not really intended but works
      * currently, so people might do it. */
-    if (srcSliceY == 0) {
+    if (dstSliceH) {
+        dstY         = dstSliceY;
+        dstEnd       = dstSliceY + dstSliceH;
+        lastInLumBuf = -1;
+        lastInChrBuf = -1;
+    } else if (srcSliceY == 0) {
         dstY         = 0;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
@@ -352,8 +365,8 @@ static int swscale(SwsContext *c, const uint8_t *src[],
             srcSliceY, srcSliceH, chrSrcSliceY, chrSrcSliceH, 1);
 
     ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
-            dstY, dstH, dstY >> c->chrDstVSubSample,
-            AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
+            dstY, dstLines, dstY >> c->chrDstVSubSample,
+            AV_CEIL_RSHIFT(dstLines, c->chrDstVSubSample), 0);
     if (srcSliceY == 0) {
         hout_slice->plane[0].sliceY = lastInLumBuf + 1;
         hout_slice->plane[1].sliceY = lastInChrBuf + 1;
@@ -367,7 +380,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -524,6 +537,68 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return swscale_internal(c, src, srcStride, srcSliceY, srcSliceH,
+                            dst, dstStride, 0, 0);
+}
+
+int ff_sws_slice_threads_supported(SwsContext *c)
+{
+    /* error diffusion carries state from one output line to the next */
+    return c->swscale == swscale && !c->cascaded_context[0] &&
+           c->dither != SWS_DITHER_ED && !c->srcXYZ && !c->dstXYZ;
+}
+
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext      *c = parent->slice_ctx[threadnr];
+    /* keep the bands aligned on chroma lines, so that each chroma line is
+     * written by exactly one band */
+    const int align    = 1 << c->chrDstVSubSample;
+    const int nb_rows  = (c->dstH + align - 1) / align;
+    const int dstY     = FFMIN(nb_rows *  jobnr      / nb_jobs * align, c->dstH);
+    const int dstEnd   = FFMIN(nb_rows * (jobnr + 1) / nb_jobs * align, c->dstH);
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    if (dstY >= dstEnd)
+        return;
+
+    /* swscale_internal() may modify these */
+    memcpy(src,       parent->slice_src,       sizeof(src));
+    memcpy(srcStride, parent->slice_srcStride, sizeof(srcStride));
+    memcpy(dst,       parent->slice_dst,       sizeof(dst));
+    memcpy(dstStride, parent->slice_dstStride, sizeof(dstStride));
+
+    if (usePal(c->srcFormat)) {
+        memcpy(c->pal_yuv, parent->pal_yuv, sizeof(c->pal_yuv));
+        memcpy(c->pal_rgb, parent->pal_rgb, sizeof(c->pal_rgb));
+    }
+
+    swscale_internal(c, src, srcStride, 0, c->srcH, dst, dstStride,
+                     dstY, dstEnd - dstY);
+}
+
+static int scale_slices(SwsContext *c, const uint8_t *src[], int srcStride[],
+                        uint8_t *dst[], int dstStride[])
+{
+    memcpy(c->slice_src,       src,       sizeof(c->slice_src));
+    memcpy(c->slice_srcStride, srcStride, sizeof(c->slice_srcStride));
+    memcpy(c->slice_dst,       dst,       sizeof(c->slice_dst));
+    memcpy(c->slice_dstStride, dstStride, sizeof(c->slice_dstStride));
+
+    avpriv_slicethread_execute(c->slicethread, c->nb_slice_ctx, 0);
+
+    c->dstY = c->dstH;
+    return c->dstH;
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -967,7 +1042,11 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+    if (c->slicethread && c->swscale == swscale &&
+        srcSliceY_internal == 0 && srcSliceH == c->srcH)
+        ret = scale_slices(c, src2, srcStride2, dst2, dstStride2);
+    else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
         int dstY = c->dstY ? c->dstY : srcSliceY + srcSliceH;
@@ -983,3 +1062,230 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     av_free(rgb0_tmp);
     return ret;
 }
+
+void sws_frame_end(struct SwsContext *c)
+{
+    av_frame_unref(c->frame_src);
+    av_frame_unref(c->frame_dst);
+    c->frame_passthrough = 0;
+    c->src_slice_end     = 0;
+    c->dst_slice_end     = 0;
+    /* a partially sent frame must not affect the next one */
+    c->sliceDir          = 0;
+}
+
+static int ref_src_buffers(AVFrame *dst, const AVFrame *src)
+{
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(src->buf) && src->buf[i]; i++) {
+        dst->buf[i] = av_buffer_ref(src->buf[i]);
+        if (!dst->buf[i])
+            return AVERROR(ENOMEM);
+    }
+    memcpy(dst->data,     src->data,     sizeof(src->data));
+    memcpy(dst->linesize, src->linesize, sizeof(src->linesize));
+
+    return 0;
+}
+
+static void unref_buffers(AVFrame *frame)
+{
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf); i++)
+        av_buffer_unref(&frame->buf[i]);
+    memset(frame->data,     0, sizeof(frame->data));
+    memset(frame->linesize, 0, sizeof(frame->linesize));
+}
+
+/* Like av_frame_get_buffer(), the planes are padded to a multiple of 32 lines
+ * plus some bytes, as encoders and filters may read past the visible area. */
+#define POOL_ALIGN         32
+#define POOL_PLANE_PADDING 64
+
+static int get_pool_buffer(SwsContext *c, AVFrame *dst)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(c->dstFormat);
+    const int padded_height = FFALIGN(c->dstH, 32);
+    uint8_t *data;
+    int i, ret;
+
+    if (!c->frame_pool) {
+        ptrdiff_t linesizes[4];
+        size_t sizes[4];
+        size_t size = 4 * POOL_PLANE_PADDING;
+
+        /* same strides as av_frame_get_buffer(), so that encoders which
+         * use suitably laid out input directly still do */
+        for (i = 1; i <= POOL_ALIGN; i += i) {
+            ret = av_image_fill_linesizes(c->frame_pool_linesize, c->dstFormat,
+                                          FFALIGN(c->dstW, i));
+            if (ret < 0)
+                return ret;
+            if (!(c->frame_pool_linesize[0] & (POOL_ALIGN - 1)))
+                break;
+        }
+        for (i = 0; i < 4 && c->frame_pool_linesize[i]; i++) {
+            if (i == 1 && desc->flags & AV_PIX_FMT_FLAG_PAL)
+                continue;
+            c->frame_pool_linesize[i] = FFALIGN(c->frame_pool_linesize[i], POOL_ALIGN);
+        }
+
+        for (i = 0; i < 4; i++)
+            linesizes[i] = c->frame_pool_linesize[i];
+        ret = av_image_fill_plane_sizes(sizes, c->dstFormat, padded_height, linesizes);
+        if (ret < 0)
+            return ret;
+
+        for (i = 0; i < 4; i++) {
+            if (sizes[i] > INT_MAX - POOL_ALIGN - size)
+                return AVERROR(EINVAL);
+            size += sizes[i];
+        }
+
+        c->frame_pool = av_buffer_pool_init(size + POOL_ALIGN, NULL);
+        if (!c->frame_pool)
+            return AVERROR(ENOMEM);
+    }
+
+    dst->buf[0] = av_buffer_pool_get(c->frame_pool);
+    if (!dst->buf[0])
+        return AVERROR(ENOMEM);
+
+    data = (uint8_t *)FFALIGN((uintptr_t)dst->buf[0]->data, POOL_ALIGN);
+    ret  = av_image_fill_pointers(dst->data, c->dstFormat, padded_height,
+                                  data, c->frame_pool_linesize);
+    if (ret < 0)
+        return ret;
+    for (i = 1; i < 4; i++) {
+        if (dst->data[i])
+            dst->data[i] += i * POOL_PLANE_PADDING;
+    }
+    memcpy(dst->linesize, c->frame_pool_linesize, sizeof(dst->linesize));
+
+    return 0;
+}
+
+int sws_frame_start(struct SwsContext *c, AVFrame *dst, const AVFrame *src)
+{
+    int ret, allocated = 0;
+
+    sws_frame_end(c);
+
+    if (!src->buf[0] || src->width != c->srcW || src->height != c->srcH) {
+        av_log(c, AV_LOG_ERROR, "Source frame does not match the context\n");
+        return AVERROR(EINVAL);
+    }
+
+    if (!c->frame_src) {
+        c->frame_src = av_frame_alloc();
+        c->frame_dst = av_frame_alloc();
+        if (!c->frame_src || !c->frame_dst)
+            return AVERROR(ENOMEM);
+    }
+
+    if (!dst->buf[0]) {
+        dst->width  = c->dstW;
+        dst->height = c->dstH;
+        dst->format = c->frame_dst_format;
+
+        if (ff_sws_is_plain_copy(c) && !src->extended_buf) {
+            ret = ref_src_buffers(dst, src);
+            c->frame_passthrough = 1;
+        } else {
+            ret = get_pool_buffer(c, dst);
+        }
+        allocated = 1;
+        if (ret < 0)
+            goto fail;
+    } else if (dst->width != c->dstW || dst->height != c->dstH) {
+        av_log(c, AV_LOG_ERROR, "Destination frame does not match the context\n");
+        return AVERROR(EINVAL);
+    }
+
+    ret = av_frame_ref(c->frame_src, src);
+    if (ret < 0)
+        goto fail;
+
+    ret = av_frame_ref(c->frame_dst, dst);
+    if (ret < 0)
+        goto fail;
+
+    return 0;
+fail:
+    if (allocated)
+        unref_buffers(dst);
+    sws_frame_end(c);
+    return ret;
+}
+
+int sws_send_slice(struct SwsContext *c, unsigned int slice_start,
+                   unsigned int slice_height)
+{
+    const AVFrame *src = c->frame_src;
+    const AVFrame *dst = c->frame_dst;
+    const AVPixFmtDescriptor *desc;
+    const uint8_t *in[4];
+    int i, ret;
+
+    if (!src || !src->buf[0] || slice_start != c->src_slice_end ||
+        slice_height > src->height - slice_start)
+        return AVERROR(EINVAL);
+
+    c->src_slice_end = slice_start + slice_height;
+
+    if (c->frame_passthrough) {
+        c->dst_slice_end = c->src_slice_end;
+        return 0;
+    }
+
+    desc = av_pix_fmt_desc_get(src->format);
+    for (i = 0; i < 4; i++) {
+        int vsub = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+        in[i] = src->data[i] ? src->data[i] + (slice_start >> vsub) * src->linesize[i]
+                             : NULL;
+    }
+    if (desc->flags & AV_PIX_FMT_FLAG_PAL)
+        in[1] = src->data[1];
+
+    ret = sws_scale(c, in, src->linesize, slice_start, slice_height,
+                    dst->data, dst->linesize);
+    if (ret < 0)
+        return ret;
+
+    c->dst_slice_end = FFMIN(c->dst_slice_end + ret, dst->height);
+    return 0;
+}
+
+int sws_receive_slice(struct SwsContext *c, unsigned int slice_start,
+                      unsigned int slice_height)
+{
+    const AVFrame *dst = c->frame_dst;
+
+    if (!dst || !dst->buf[0] || slice_start > dst->height ||
+        slice_height > dst->height - slice_start)
+        return AVERROR(EINVAL);
+
+    if (slice_start + slice_height > c->dst_slice_end)
+        return AVERROR(EAGAIN);
+
+    return 0;
+}
+
+int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src)
+{
+    int ret;
+
+    ret = sws_frame_start(c, dst, src);
+    if (ret < 0)
+        return ret;
+
+    ret = sws_send_slice(c, 0, src->height);
+    if (ret >= 0)
+        ret = sws_receive_slice(c, 0, dst->height);
+
+    sws_frame_end(c);
+
+    return ret;
+}
@@ -26,12 +26,15 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
+#include "libavutil/buffer.h"
 #include "libavutil/common.h"
+#include "libavutil/frame.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
 #include "libavutil/mem_internal.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/ppc/util_altivec.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
@@ -324,6 +327,31 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields allow splitting the output image into horizontal
+     * bands that are scaled in parallel, each by its own context. Only used
+     * when a whole frame is passed to sws_scale().
+     */
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    AVSliceThread *slicethread;
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    const uint8_t *slice_src[4];  ///< Source planes of the frame being scaled by the slice contexts.
+    int slice_srcStride[4];
+    uint8_t *slice_dst[4];        ///< Destination planes of the frame being scaled by the slice contexts.
+    int slice_dstStride[4];
+
+    /* The frame_* fields hold the state of the frame based API, from
+     * sws_frame_start() to sws_frame_end().
+     */
+    AVFrame *frame_src;
+    AVFrame *frame_dst;
+    int frame_passthrough;        ///< frame_dst references the buffers of frame_src.
+    int src_slice_end;            ///< Number of input lines sent for the current frame.
+    int dst_slice_end;            ///< Number of output lines written for the current frame.
+    enum AVPixelFormat frame_dst_format; ///< Destination format before handle_jpeg() and handle_formats().
+    AVBufferPool *frame_pool;     ///< Pool of destination frame buffers.
+    int frame_pool_linesize[4];
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -866,12 +894,31 @@ void ff_get_unscaled_swscale_ppc(SwsContext *c);
 void ff_get_unscaled_swscale_arm(SwsContext *c);
 void ff_get_unscaled_swscale_aarch64(SwsContext *c);
 
+/**
+ * Return 1 if the conversion done by c leaves the image data unchanged,
+ * so that the output planes may simply reference the input planes.
+ */
+int ff_sws_is_plain_copy(SwsContext *c);
+
 /**
  * Return function pointer to fastest main scaler path function depending
  * on architecture and available optimizations.
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+/**
+ * Return 1 if the conversion done by c can be split into horizontal bands of
+ * the output image that are scaled independently, 0 otherwise.
+ */
+int ff_sws_slice_threads_supported(SwsContext *c);
+
+/**
+ * Slice thread worker, scales band jobnr of the frame set in
+ * c->slice_src/slice_dst with the slice context of thread threadnr.
+ */
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
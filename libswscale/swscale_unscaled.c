@@ -2228,6 +2228,14 @@ void ff_get_unscaled_swscale(SwsContext *c)
         ff_get_unscaled_swscale_aarch64(c);
 }
 
+int ff_sws_is_plain_copy(SwsContext *c)
+{
+    return c->srcFormat == c->dstFormat &&
+           c->srcW == c->dstW && c->srcH == c->dstH &&
+           !c->cascaded_context[0] &&
+           (c->swscale == packedCopyWrapper || c->swscale == planarCopyWrapper);
+}
+
 /* Convert the palette to the same packed 32-bit format as the palette */
 void sws_convertPalette8ToPacked32(const uint8_t *src, uint8_t *dst,
                                    int num_pixels, const uint8_t *palette)
@@ -0,0 +1,249 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that sws_scale_frame() and the slice API give the same output as
+ * sws_scale(), both into caller allocated frames and into frames from the
+ * pool of the context.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+#define SLICE_H 16
+
+static const struct {
+    enum AVPixelFormat src_fmt;
+    int src_w, src_h;
+    enum AVPixelFormat dst_fmt;
+    int dst_w, dst_h;
+} tests[] = {
+    { AV_PIX_FMT_YUV420P,  96,  64, AV_PIX_FMT_RGB24,    96,  64 },
+    { AV_PIX_FMT_YUV420P,  96,  64, AV_PIX_FMT_YUV422P,  48,  40 },
+    { AV_PIX_FMT_RGB24,    80,  60, AV_PIX_FMT_YUV420P, 160, 122 },
+    { AV_PIX_FMT_GRAY8,    64,  50, AV_PIX_FMT_RGBA,     30,  20 },
+    { AV_PIX_FMT_YUV444P,  64,  48, AV_PIX_FMT_YUV444P,  64,  48 },
+};
+
+static AVFrame *alloc_frame(enum AVPixelFormat format, int w, int h)
+{
+    AVFrame *frame = av_frame_alloc();
+
+    if (!frame)
+        return NULL;
+    frame->format = format;
+    frame->width  = w;
+    frame->height = h;
+    if (av_frame_get_buffer(frame, 0) < 0)
+        av_frame_free(&frame);
+    return frame;
+}
+
+static void fill_frame(AVFrame *frame, AVLFG *rand)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    int linesizes[4];
+    int p, x, y;
+
+    av_image_fill_linesizes(linesizes, frame->format, frame->width);
+    for (p = 0; p < 4 && frame->data[p]; p++) {
+        int h = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                   : frame->height;
+        for (y = 0; y < h; y++)
+            for (x = 0; x < linesizes[p]; x++)
+                frame->data[p][y * frame->linesize[p] + x] = av_lfg_get(rand);
+    }
+}
+
+static int compare_frames(const AVFrame *a, const AVFrame *b)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->format);
+    int linesizes[4];
+    int p, y;
+
+    if (a->format != b->format || a->width != b->width || a->height != b->height)
+        return -1;
+
+    av_image_fill_linesizes(linesizes, a->format, a->width);
+    for (p = 0; p < 4 && a->data[p]; p++) {
+        int h = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h)
+                                   : a->height;
+        for (y = 0; y < h; y++)
+            if (memcmp(a->data[p] + y * a->linesize[p],
+                       b->data[p] + y * b->linesize[p], linesizes[p]))
+                return -1;
+    }
+    return 0;
+}
+
+static int scale_slices(struct SwsContext *sws, AVFrame *dst, const AVFrame *src)
+{
+    int y, ret;
+
+    ret = sws_frame_start(sws, dst, src);
+    if (ret < 0)
+        return ret;
+
+    /* nothing can be complete before anything has been sent */
+    if (sws_receive_slice(sws, 0, dst->height) != AVERROR(EAGAIN)) {
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    for (y = 0; y < src->height; y += SLICE_H) {
+        ret = sws_send_slice(sws, y, FFMIN(SLICE_H, src->height - y));
+        if (ret < 0)
+            goto end;
+        if (y + SLICE_H < src->height &&
+            sws_receive_slice(sws, 0, dst->height) != AVERROR(EAGAIN)) {
+            ret = AVERROR_BUG;
+            goto end;
+        }
+    }
+    ret = sws_receive_slice(sws, 0, dst->height);
+
+end:
+    sws_frame_end(sws);
+    return ret;
+}
+
+static int run_test(int i, AVLFG *rand)
+{
+    AVFrame *src = NULL, *ref = NULL, *dst = NULL;
+    struct SwsContext *sws;
+    int ret, passthrough, slices_ok = 0, frame_ok = 0, pool_ok = 0;
+
+    sws = sws_getContext(tests[i].src_w, tests[i].src_h, tests[i].src_fmt,
+                         tests[i].dst_w, tests[i].dst_h, tests[i].dst_fmt,
+                         SWS_BILINEAR | SWS_BITEXACT | SWS_ACCURATE_RND,
+                         NULL, NULL, NULL);
+    src = alloc_frame(tests[i].src_fmt, tests[i].src_w, tests[i].src_h);
+    ref = alloc_frame(tests[i].dst_fmt, tests[i].dst_w, tests[i].dst_h);
+    dst = alloc_frame(tests[i].dst_fmt, tests[i].dst_w, tests[i].dst_h);
+    if (!sws || !src || !ref || !dst) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    fill_frame(src, rand);
+
+    ret = sws_scale(sws, (const uint8_t * const *)src->data, src->linesize,
+                    0, src->height, ref->data, ref->linesize);
+    if (ret != ref->height) {
+        fprintf(stderr, "sws_scale failed\n");
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    /* into a caller allocated frame */
+    ret = sws_scale_frame(sws, dst, src);
+    frame_ok = ret >= 0 && !compare_frames(ref, dst);
+
+    /* into a frame from the pool, in slices */
+    av_frame_unref(dst);
+    ret = scale_slices(sws, dst, src);
+    slices_ok = ret >= 0 && !compare_frames(ref, dst);
+    passthrough = dst->buf[0] && dst->buf[0]->buffer == src->buf[0]->buffer;
+
+    /* again, while the previous pool frame is still referenced */
+    av_frame_unref(ref);
+    av_frame_move_ref(ref, dst);
+    ret = sws_scale_frame(sws, dst, src);
+    pool_ok = ret >= 0 && !compare_frames(ref, dst) &&
+              (passthrough || dst->data[0] != ref->data[0]);
+
+    printf("%s %dx%d -> %s %dx%d: frame %s, slices %s, pool %s%s\n",
+           av_get_pix_fmt_name(tests[i].src_fmt), tests[i].src_w, tests[i].src_h,
+           av_get_pix_fmt_name(tests[i].dst_fmt), tests[i].dst_w, tests[i].dst_h,
+           frame_ok  ? "ok" : "FAIL",
+           slices_ok ? "ok" : "FAIL",
+           pool_ok   ? "ok" : "FAIL",
+           passthrough ? ", passthrough" : "");
+    ret = frame_ok && slices_ok && pool_ok ? 0 : AVERROR_BUG;
+
+end:
+    av_frame_free(&src);
+    av_frame_free(&ref);
+    av_frame_free(&dst);
+    sws_freeContext(sws);
+    return ret;
+}
+
+static int check_errors(AVLFG *rand)
+{
+    AVFrame *src, *dst = av_frame_alloc();
+    struct SwsContext *sws;
+    int errors = 0;
+
+    sws = sws_getContext(64, 64, AV_PIX_FMT_YUV420P, 32, 32, AV_PIX_FMT_YUV420P,
+                         SWS_BILINEAR | SWS_BITEXACT, NULL, NULL, NULL);
+    src = alloc_frame(AV_PIX_FMT_YUV420P, 64, 48);
+    if (!sws || !src || !dst) {
+        errors++;
+        goto end;
+    }
+    fill_frame(src, rand);
+
+    /* the source does not match the context */
+    errors += sws_scale_frame(sws, dst, src) != AVERROR(EINVAL);
+
+    /* slices must be sent in order */
+    av_frame_free(&src);
+    src = alloc_frame(AV_PIX_FMT_YUV420P, 64, 64);
+    if (!src || sws_frame_start(sws, dst, src) < 0) {
+        errors++;
+        goto end;
+    }
+    errors += sws_send_slice(sws, 16, 16) != AVERROR(EINVAL);
+    errors += sws_send_slice(sws, 0, 65)  != AVERROR(EINVAL);
+    errors += sws_send_slice(sws, 0, 32)  < 0;
+    errors += sws_receive_slice(sws, 0, 33) != AVERROR(EINVAL);
+    sws_frame_end(sws);
+
+    printf("error checks: %s\n", errors ? "FAIL" : "ok");
+
+end:
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    sws_freeContext(sws);
+    return errors;
+}
+
+int main(void)
+{
+    AVLFG rand;
+    int i, ret = 0;
+
+    av_lfg_init(&rand, 1);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++)
+        if (run_test(i, &rand) < 0)
+            ret = 1;
+
+    if (check_errors(&rand))
+        ret = 1;
+
+    return ret;
+}
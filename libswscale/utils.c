@@ -877,6 +877,17 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
 
+    if (c->slicethread) {
+        int i, ret;
+        for (i = 0; i < c->nb_slice_ctx; i++) {
+            ret = sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                           table, dstRange, brightness,
+                                           contrast, saturation);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
     desc_src = av_pix_fmt_desc_get(c->srcFormat);
@@ -1176,8 +1187,8 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
-av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
-                             SwsFilter *dstFilter)
+static av_cold int context_init_single(SwsContext *c, SwsFilter *srcFilter,
+                                       SwsFilter *dstFilter)
 {
     int i;
     int usesVFilter, usesHFilter;
@@ -1205,6 +1216,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 
     unscaled = (srcW == dstW && srcH == dstH);
 
+    c->frame_dst_format = c->dstFormat;
     c->srcRange |= handle_jpeg(&c->srcFormat);
     c->dstRange |= handle_jpeg(&c->dstFormat);
 
@@ -1889,6 +1901,91 @@ fail: // FIXME replace things by appropriate error codes
     return ret;
 }
 
+static void free_slice_threads(SwsContext *c)
+{
+    int i;
+
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    c->nb_slice_ctx = 0;
+}
+
+/* The slice contexts must be created from the options set by the user,
+ * before sws_init_context() adjusts them for the main context. */
+static av_cold int alloc_slice_contexts(SwsContext *c)
+{
+    int i, ret, nb_threads = c->nb_threads ? c->nb_threads : av_cpu_count();
+
+    if (nb_threads <= 1)
+        return 0;
+
+    c->slice_ctx = av_mallocz_array(nb_threads, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+    c->nb_slice_ctx = nb_threads;
+
+    for (i = 0; i < nb_threads; i++) {
+        c->slice_ctx[i] = sws_alloc_context();
+        if (!c->slice_ctx[i])
+            return AVERROR(ENOMEM);
+        ret = av_opt_copy(c->slice_ctx[i], c);
+        if (ret < 0)
+            return ret;
+        c->slice_ctx[i]->nb_threads = 1;
+    }
+
+    return 0;
+}
+
+static av_cold int init_slice_threads(SwsContext *c, SwsFilter *srcFilter,
+                                      SwsFilter *dstFilter)
+{
+    int i, ret;
+
+    if (!ff_sws_slice_threads_supported(c)) {
+        free_slice_threads(c);
+        return 0;
+    }
+
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        ret = context_init_single(c->slice_ctx[i], srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = avpriv_slicethread_create(&c->slicethread, c, ff_sws_slice_worker,
+                                    NULL, c->nb_slice_ctx);
+    if (ret == AVERROR(ENOSYS)) {
+        /* threading is not available in this build */
+        free_slice_threads(c);
+        return 0;
+    }
+    if (ret < 0)
+        return ret;
+
+    return 0;
+}
+
+av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
+                             SwsFilter *dstFilter)
+{
+    int ret;
+
+    if (c->nb_threads != 1) {
+        ret = alloc_slice_contexts(c);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = context_init_single(c, srcFilter, dstFilter);
+    if (ret < 0 || !c->nb_slice_ctx)
+        return ret;
+
+    return init_slice_threads(c, srcFilter, dstFilter);
+}
+
 SwsContext *sws_alloc_set_opts(int srcW, int srcH, enum AVPixelFormat srcFormat,
                                int dstW, int dstH, enum AVPixelFormat dstFormat,
                                int flags, const double *param)
@@ -2340,6 +2437,12 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    free_slice_threads(c);
+
+    av_frame_free(&c->frame_src);
+    av_frame_free(&c->frame_dst);
+    av_buffer_pool_uninit(&c->frame_pool);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
@@ -386,6 +386,7 @@ video_filter(){
     filters=$1
     shift
     label=${test#filter-}
+    label=${label%-slice}
     raw_src="${target_path}/tests/vsynth1/%02d.pgm"
     printf '%-20s' $label
     ffmpeg $DEC_OPTS -f image2 -vcodec pgmyuv -i $raw_src \
@@ -446,6 +447,67 @@ gapless(){
     do_md5sum $decfile3
 }
 
+mov_lazy_index(){
+    srcfile="${outdir}/${test}.mp4"
+    decfile1="${outdir}/${test}.out-1"
+    decfile2="${outdir}/${test}.out-2"
+    cleanfiles="$cleanfiles $srcfile $decfile1 $decfile2"
+
+    # longer tracks than the index window, with B-frames and AAC priming
+    ffmpeg -f lavfi -i sine=r=8000:d=560 -f lavfi -i testsrc=s=32x32:r=10:d=560 \
+        -af aresample -vf scale -pix_fmt yuv420p -c:a aac -b:a 16k \
+        -c:v mpeg4 -g 50 -bf 2 -y $(target_path $srcfile) || return
+
+    # the packets must be the same as with the full index, also after seeking
+    for lazy in 0 1; do
+        decfile=$decfile1
+        test $lazy = 1 && decfile=$decfile2
+        for ss in 0 0.2 300 555; do
+            ffmpeg -lazy_index $lazy -ss $ss -i $(target_path $srcfile) -c copy \
+                -bitexact -f framecrc - || return
+        done > $decfile
+    done
+    diff -u $decfile1 $decfile2
+}
+
+pad_headroom(){
+    pad=$1
+    raw_src="${target_path}/tests/vsynth1/%02d.pgm"
+    logfile="${outdir}/${test}.log"
+    cleanfiles="$cleanfiles $logfile"
+
+    # once the graph is configured, the decoder allocates room for pad, also
+    # through filters passing the frames on unchanged, but not through crop
+    i=0
+    for filters in "$pad" "null,setpts=PTS-STARTPTS,format=yuv420p,$pad" \
+                   "crop=iw:ih:0:0,$pad"; do
+        i=$((i + 1))
+        decfile="${outdir}/${test}.out-$i"
+        cleanfiles="$cleanfiles $decfile"
+        ffmpeg -v repeat+debug -c:v pgmyuv -i $raw_src -vf "$filters" -frames:v 5 \
+            -bitexact -f framecrc -y $(target_path $decfile) 2> $logfile || return
+        echo "$filters: $(grep -c "Direct padding impossible" $logfile) frames copied"
+    done
+    diff -u ${outdir}/${test}.out-1 ${outdir}/${test}.out-2 &&
+    diff -u ${outdir}/${test}.out-1 ${outdir}/${test}.out-3 &&
+    cat ${outdir}/${test}.out-1
+}
+
+mux_threads(){
+    queue_size=$1
+    outfile1="${outdir}/${test}.out-1"
+    outfile2="${outdir}/${test}.out-2"
+    cleanfiles="$cleanfiles $outfile1 $outfile2"
+
+    # both outputs are written by their own muxer thread unless the queue size is 0
+    ffmpeg -f lavfi -i testsrc2=s=64x48:r=25:d=2 -f lavfi -i sine=r=8000:d=2 \
+        -thread_queue_size $queue_size -map 0:v -map 1:a -c:v rawvideo -c:a pcm_s16le \
+        -bitexact -f framecrc -y $(target_path $outfile1) \
+        -thread_queue_size $queue_size -map 0:v -map 1:a -c:v mpeg4 -qscale:v 4 -threads 1 \
+        -c:a pcm_s16be -bitexact -f framecrc -y $(target_path $outfile2) || return
+    cat $outfile1 $outfile2
+}
+
 gaplessenc(){
     sample=$(target_path $1)
     format=$2
@@ -26,6 +26,14 @@ fate-mapchan: $(FATE_MAPCHAN)
 FATE_FFMPEG-$(CONFIG_COLOR_FILTER) += fate-ffmpeg-filter_complex
 fate-ffmpeg-filter_complex: CMD = framecrc -filter_complex color=d=1:r=5 -fflags +bitexact
 
+# Muxing to several outputs, each from its own thread with a small queue and
+# without threads, must give the same packets.
+FATE_FFMPEG_MUX_THREADS = fate-ffmpeg-mux-threads fate-ffmpeg-mux-threads-off
+FATE_FFMPEG-$(call ALLYES, TESTSRC2_FILTER SINE_FILTER RAWVIDEO_ENCODER PCM_S16LE_ENCODER MPEG4_ENCODER PCM_S16BE_ENCODER FRAMECRC_MUXER) += $(FATE_FFMPEG_MUX_THREADS)
+fate-ffmpeg-mux-threads: CMD = mux_threads 1
+fate-ffmpeg-mux-threads-off: CMD = mux_threads 0
+fate-ffmpeg-mux-threads-off: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-mux-threads
+
 # Ticket 6603
 FATE_FFMPEG-$(call ALLYES, AEVALSRC_FILTER ASETNSAMPLES_FILTER AC3_FIXED_ENCODER) += fate-ffmpeg-filter_complex_audio
 fate-ffmpeg-filter_complex_audio: CMD = framecrc -auto_conversion_filters -filter_complex "aevalsrc=0:d=0.1,asetnsamples=1537" -c ac3_fixed
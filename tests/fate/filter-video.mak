@@ -122,6 +122,15 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER FORMAT_FILTER) += fa
 fate-filter-framerate-12bit-up: CMD = framecrc -lavfi testsrc2=r=50:d=1,format=pix_fmts=yuv422p12le,scale,framerate=fps=60,scale -t 1 -pix_fmt yuv422p12le
 fate-filter-framerate-12bit-down: CMD = framecrc -lavfi testsrc2=r=60:d=1,format=pix_fmts=yuv422p12le,scale,framerate=fps=50,scale -t 1 -pix_fmt yuv422p12le
 
+# The branches after split run concurrently with the filter thread type, and
+# must give the same output as when the graph is run serially.
+FILTER_CONCURRENT_GRAPH = "sws_flags=+accurate_rnd+bitexact;testsrc2=s=320x240:r=5:d=2,split=3[a][b][c];[a]hflip,scale=160:120[a1];[b]vflip,avgblur=2,scale=160:120[b1];[c]negate,graphmonitor=s=160x120:f=format+size+rate+timebase:r=5,scale,format=yuv420p[c1];[a1][b1][c1]hstack=3"
+FATE_FILTER_CONCURRENT = fate-filter-graph-concurrent fate-filter-graph-concurrent-slice
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER HFLIP_FILTER VFLIP_FILTER AVGBLUR_FILTER NEGATE_FILTER GRAPHMONITOR_FILTER SCALE_FILTER FORMAT_FILTER HSTACK_FILTER) += $(FATE_FILTER_CONCURRENT)
+fate-filter-graph-concurrent: CMD = framecrc -filter_threads 4 -filter_thread_type filter -lavfi $(FILTER_CONCURRENT_GRAPH)
+fate-filter-graph-concurrent-slice: CMD = framecrc -filter_threads 4 -filter_thread_type filter+slice -lavfi $(FILTER_CONCURRENT_GRAPH)
+fate-filter-graph-concurrent-slice: REF = $(SRC_PATH)/tests/ref/fate/filter-graph-concurrent
+
 FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-minterpolate-up fate-filter-minterpolate-down
 fate-filter-minterpolate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=10 -t 1
 fate-filter-minterpolate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=1 -t 1
@@ -135,6 +144,25 @@ fate-filter-colorchannelmixer: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,fo
 FATE_FILTER_VSYNTH-$(CONFIG_DRAWBOX_FILTER) += fate-filter-drawbox
 fate-filter-drawbox: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf drawbox=224:24:88:72:red@0.5
 
+FATE_FILLBORDERS += fate-filter-fillborders-smear
+fate-filter-fillborders-smear: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf fillborders=left=9:right=7:top=5:bottom=3 -frames:v 5
+
+FATE_FILLBORDERS += fate-filter-fillborders-mirror
+fate-filter-fillborders-mirror: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf fillborders=left=9:right=7:top=5:bottom=3:mode=mirror -frames:v 5
+
+FATE_FILLBORDERS += fate-filter-fillborders-fade
+fate-filter-fillborders-fade: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf fillborders=left=9:right=7:top=5:bottom=3:mode=fade:color=red -frames:v 5
+
+FATE_FILLBORDERS += fate-filter-fillborders-mirror-slice
+fate-filter-fillborders-mirror-slice: CMD = framecrc -filter_threads 4 -c:v pgmyuv -i $(SRC) -vf fillborders=left=9:right=7:top=5:bottom=3:mode=mirror -frames:v 5
+fate-filter-fillborders-mirror-slice: REF = $(SRC_PATH)/tests/ref/fate/filter-fillborders-mirror
+
+FATE_FILLBORDERS += fate-filter-fillborders-fade-slice
+fate-filter-fillborders-fade-slice: CMD = framecrc -filter_threads 4 -c:v pgmyuv -i $(SRC) -vf fillborders=left=9:right=7:top=5:bottom=3:mode=fade:color=red -frames:v 5
+fate-filter-fillborders-fade-slice: REF = $(SRC_PATH)/tests/ref/fate/filter-fillborders-fade
+
+FATE_FILTER_VSYNTH-$(CONFIG_FILLBORDERS_FILTER) += $(FATE_FILLBORDERS)
+
 FATE_FILTER_VSYNTH-$(CONFIG_FADE_FILTER) += fate-filter-fade
 fate-filter-fade: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf fade=in:5:15,fade=out:30:15
 
@@ -379,6 +407,10 @@ FATE_FILTER_VSYNTH-$(CONFIG_SHUFFLEPLANES_FILTER) += $(FATE_SHUFFLEPLANES)
 FATE_SWAPRECT += fate-filter-swaprect
 fate-filter-swaprect: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf swaprect
 
+FATE_SWAPRECT += fate-filter-swaprect-slice
+fate-filter-swaprect-slice: CMD = framecrc -filter_threads 4 -c:v pgmyuv -i $(SRC) -vf swaprect
+fate-filter-swaprect-slice: REF = $(SRC_PATH)/tests/ref/fate/filter-swaprect
+
 FATE_FILTER_VSYNTH-$(CONFIG_SWAPRECT_FILTER) += $(FATE_SWAPRECT)
 
 FATE_FILTER_VSYNTH-$(CONFIG_TBLEND_FILTER) += fate-filter-tblend
@@ -561,6 +593,14 @@ fate-filter-idet: CMD = framecrc -flags bitexact -idct simple -i $(SRC) -vf idet
 FATE_FILTER_VSYNTH-$(CONFIG_PAD_FILTER) += fate-filter-pad
 fate-filter-pad: CMD = video_filter "pad=iw*1.5:ih*1.5:iw*0.3:ih*0.2"
 
+FATE_FILTER_VSYNTH-$(CONFIG_PAD_FILTER) += fate-filter-pad-slice
+fate-filter-pad-slice: CMD = video_filter "pad=iw*1.5:ih*1.5:iw*0.3:ih*0.2" -filter_threads 4
+fate-filter-pad-slice: REF = $(SRC_PATH)/tests/ref/fate/filter-pad
+
+# pad in place into the frames of the decoder, and through a copy
+FATE_FILTER_VSYNTH-$(call ALLYES, PAD_FILTER NULL_FILTER SETPTS_FILTER FORMAT_FILTER CROP_FILTER) += fate-filter-pad-headroom
+fate-filter-pad-headroom: CMD = pad_headroom pad=iw+32:ih+16:16:8:color=red
+
 FATE_FILTER_PP = fate-filter-pp fate-filter-pp1 fate-filter-pp2 fate-filter-pp3 fate-filter-pp4 fate-filter-pp5 fate-filter-pp6
 FATE_FILTER_VSYNTH-$(CONFIG_PP_FILTER) += $(FATE_FILTER_PP)
 $(FATE_FILTER_PP): fate-vsynth1-mpeg4-qprd
@@ -673,6 +713,10 @@ fate-filter-thumbnail: CMD = video_filter "scale,thumbnail=10"
 FATE_FILTER_VSYNTH-$(CONFIG_TILE_FILTER) += fate-filter-tile
 fate-filter-tile: CMD = video_filter "tile=3x3:nb_frames=5:padding=7:margin=2"
 
+FATE_FILTER_VSYNTH-$(CONFIG_TILE_FILTER) += fate-filter-tile-slice
+fate-filter-tile-slice: CMD = video_filter "tile=3x3:nb_frames=5:padding=7:margin=2" -filter_threads 4
+fate-filter-tile-slice: REF = $(SRC_PATH)/tests/ref/fate/filter-tile
+
 
 tests/pixfmts.mak: TAG = GEN
 tests/pixfmts.mak: ffmpeg$(PROGSSUF)$(EXESUF) | tests
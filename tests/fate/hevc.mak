@@ -230,6 +230,18 @@ FATE_HEVC_LARGE += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv444p12le -vf scale
 endef
 
+# decode the WPP streams with slice threads, alone and inside frame threads,
+# against the refs of the single threaded decode
+HEVC_SAMPLES_WPP       = $(filter WPP_%_ericsson_MAIN_2,$(HEVC_SAMPLES))
+HEVC_SAMPLES_WPP_10BIT = $(filter WPP_%_ericsson_MAIN10_2,$(HEVC_SAMPLES_10BIT))
+
+define FATE_HEVC_WPP_TEST
+FATE_HEVC += fate-hevc-conformance-$(1)-slice fate-hevc-conformance-$(1)-frame-slice
+fate-hevc-conformance-$(1)-slice: CMD = framecrc -flags unaligned -threads 4 -thread_type slice -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit $(2)
+fate-hevc-conformance-$(1)-frame-slice: CMD = framecrc -flags unaligned -threads 4 -thread_type frame+slice -frame_slice_threads 2 -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit $(2)
+fate-hevc-conformance-$(1)-slice fate-hevc-conformance-$(1)-frame-slice: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+endef
+
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIT),$(eval $(call FATE_HEVC_TEST_422_10BIT,$(N))))
@@ -238,6 +250,8 @@ $(foreach N,$(HEVC_SAMPLES_422_10BIN_LARGE),$(eval $(call FATE_HEVC_TEST_422_10B
 $(foreach N,$(HEVC_SAMPLES_444_8BIT),$(eval $(call FATE_HEVC_TEST_444_8BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT),$(eval $(call FATE_HEVC_TEST_444_12BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT_LARGE),$(eval $(call FATE_HEVC_TEST_444_12BIT_LARGE,$(N))))
+$(foreach N,$(HEVC_SAMPLES_WPP),$(eval $(call FATE_HEVC_WPP_TEST,$(N),-pix_fmt yuv420p)))
+$(foreach N,$(HEVC_SAMPLES_WPP_10BIT),$(eval $(call FATE_HEVC_WPP_TEST,$(N),-pix_fmt yuv420p10le -vf scale)))
 
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC_LARGE += fate-hevc-paramchange-yuv420p-yuv420p10
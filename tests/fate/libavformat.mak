@@ -6,6 +6,11 @@ FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy$(EXESUF)
 
+FATE_PREFETCH-$(call ALLYES, HLS_DEMUXER FILE_PROTOCOL) += fate-prefetch
+FATE_LIBAVFORMAT-$(HAVE_THREADS) += $(FATE_PREFETCH-yes)
+fate-prefetch: libavformat/tests/prefetch$(EXESUF)
+fate-prefetch: CMD = run libavformat/tests/prefetch$(EXESUF) $(TARGET_PATH)/tests/data/fate/prefetch.data
+
 FATE_LIBAVFORMAT-$(CONFIG_FFRTMPCRYPT_PROTOCOL) += fate-rtmpdh
 fate-rtmpdh: libavformat/tests/rtmpdh$(EXESUF)
 fate-rtmpdh: CMD = run libavformat/tests/rtmpdh$(EXESUF)
@@ -166,11 +166,15 @@ fate-vsynth%-dv-hd:              ENCOPTS = -dct int -s 960x720 -pix_fmt yuv422p
 fate-vsynth%-dv-hd:              DECOPTS = -sws_flags neighbor
 fate-vsynth%-dv-hd:              FMT     = dv
 
-FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1 ffv1-v0 \
+FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1 ffv1-v0 ffv1-lowdelay \
                                            ffv1-v3-yuv420p ffv1-v3-yuv422p10 ffv1-v3-yuv444p16 \
                                            ffv1-v3-bgr0 ffv1-v3-rgb48
 fate-vsynth%-ffv1:               ENCOPTS = -slices 4
 fate-vsynth%-ffv1-v0:            CODEC   = ffv1
+fate-vsynth%-ffv1-lowdelay:      CODEC   = ffv1
+fate-vsynth%-ffv1-lowdelay:      ENCOPTS = -slices 4
+fate-vsynth%-ffv1-lowdelay:      DECINOPTS = -thread_type frame -frame_thread_max_delay 3
+fate-vsynth%-ffv1-lowdelay:      THREADS = 3
 fate-vsynth%-ffv1-v3-yuv420p:    ENCOPTS = -level 3 -pix_fmt yuv420p
 fate-vsynth%-ffv1-v3-yuv422p10:  ENCOPTS = -level 3 -pix_fmt yuv422p10 \
                                            -sws_flags neighbor+bitexact
@@ -243,6 +247,17 @@ fate-vsynth%-mjpeg-trell:             ENCOPTS = -qscale 9 -pix_fmt yuvj420p -tre
 fate-vsynth%-mjpeg-huffman:           ENCOPTS = -qscale 9 -pix_fmt yuvj420p -huffman optimal
 fate-vsynth%-mjpeg-trell-huffman:     ENCOPTS = -qscale 9 -pix_fmt yuvj420p -trellis 1 -huffman optimal
 
+# the slice threaded encoder writes restart markers, decode them with and
+# without slice threads
+FATE_MJPEG_RST-$(call ENCDEC, MJPEG, AVI) += fate-vsynth1-mjpeg-rst fate-mjpeg-rst fate-mjpeg-rst-slice
+fate-vsynth1-mjpeg-rst:               ENCOPTS = -qscale 9 -pix_fmt yuvj420p -threads 4 -thread_type slice
+fate-vsynth1-mjpeg-rst:               KEEP_OVERRIDE = -keep
+fate-vsynth1-mjpeg-rst:               tests/data/vsynth1.yuv
+fate-mjpeg-rst fate-mjpeg-rst-slice:  fate-vsynth1-mjpeg-rst
+fate-mjpeg-rst:       CMD = framecrc -idct simple -i $(TARGET_PATH)/tests/data/fate/vsynth1-mjpeg-rst.avi
+fate-mjpeg-rst-slice: CMD = framecrc -idct simple -threads 4 -thread_type slice -i $(TARGET_PATH)/tests/data/fate/vsynth1-mjpeg-rst.avi
+fate-mjpeg-rst-slice: REF = $(SRC_PATH)/tests/ref/fate/mjpeg-rst
+
 FATE_VCODEC-$(call ENCDEC, MPEG1VIDEO, MPEG1VIDEO MPEGVIDEO) += mpeg1 mpeg1b
 fate-vsynth%-mpeg1:              FMT     = mpeg1video
 fate-vsynth%-mpeg1:              CODEC   = mpeg1video
@@ -483,6 +498,7 @@ $(FATE_VSYNTH_LENA): tests/data/vsynth_lena.yuv
 $(FATE_VSYNTH3): tests/data/vsynth3.yuv
 
 FATE_AVCONV += $(FATE_VSYNTH1) $(FATE_VSYNTH2) $(FATE_VSYNTH3)
+FATE_AVCONV += $(FATE_MJPEG_RST-yes)
 FATE_SAMPLES_AVCONV += $(FATE_VSYNTH_LENA)
 
 fate-vsynth1: $(FATE_VSYNTH1)
@@ -0,0 +1,161 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure how long it takes to open a file and get its first packet, and
+ * the peak memory used for it, e.g. to compare demuxer options:
+ *
+ *   demux_bench -o lazy_index=1 long.mp4 3600 43200
+ *
+ * Each trailing argument is a time in seconds to seek to, after which one
+ * packet is read. The peak RSS is that of the whole process, so run one
+ * configuration per invocation.
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+#if HAVE_SYS_RESOURCE_H
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include "libavformat/avformat.h"
+#include "libavutil/dict.h"
+#include "libavutil/time.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static void usage(int ret)
+{
+    fprintf(ret ? stderr : stdout,
+            "Usage: demux_bench [-o key=value] file [seek_time ...]\n"
+            "    -o key=value    set a demuxer option, may be repeated\n"
+            "    -f format       force the input format\n"
+            );
+    exit(ret);
+}
+
+static int64_t get_max_rss(void)
+{
+#if HAVE_GETRUSAGE && HAVE_STRUCT_RUSAGE_RU_MAXRSS
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return (int64_t)rusage.ru_maxrss * 1024;
+#else
+    return 0;
+#endif
+}
+
+static void print_step(const char *name, int64_t start)
+{
+    printf("%-12s %10.3f ms %10"PRId64" kB\n", name,
+           (av_gettime_relative() - start) / 1000.0, get_max_rss() / 1024);
+}
+
+int main(int argc, char **argv)
+{
+    int opt, ret;
+    const char *filename;
+    AVFormatContext *avf = NULL;
+    AVDictionary *opts = NULL;
+    AVInputFormat *fmt = NULL;
+    AVPacket *pkt;
+    int64_t start, total;
+
+    while ((opt = getopt(argc, argv, "ho:f:")) != -1) {
+        switch (opt) {
+        case 'o':
+            if (av_dict_parse_string(&opts, optarg, "=", ":", 0) < 0) {
+                fprintf(stderr, "invalid option '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            if (!(fmt = av_find_input_format(optarg))) {
+                fprintf(stderr, "unknown format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'h':
+            usage(0);
+        default:
+            usage(1);
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (!argc)
+        usage(1);
+    filename = *argv;
+    argv++;
+    argc--;
+
+    if (!(pkt = av_packet_alloc()))
+        return 1;
+
+    total = start = av_gettime_relative();
+    if ((ret = avformat_open_input(&avf, filename, fmt, &opts)) < 0) {
+        fprintf(stderr, "%s: %s\n", filename, av_err2str(ret));
+        return 1;
+    }
+    print_step("open", start);
+
+    start = av_gettime_relative();
+    if ((ret = avformat_find_stream_info(avf, NULL)) < 0) {
+        fprintf(stderr, "%s: could not find codec parameters: %s\n", filename,
+                av_err2str(ret));
+        return 1;
+    }
+    print_step("stream info", start);
+
+    start = av_gettime_relative();
+    if ((ret = av_read_frame(avf, pkt)) < 0) {
+        fprintf(stderr, "read: %s\n", av_err2str(ret));
+        return 1;
+    }
+    av_packet_unref(pkt);
+    print_step("first packet", start);
+    print_step("total", total);
+
+    for (; argc; argc--, argv++) {
+        char name[32];
+        int64_t ts = strtod(*argv, NULL) * AV_TIME_BASE;
+
+        start = av_gettime_relative();
+        ret = avformat_seek_file(avf, -1, INT64_MIN, ts, INT64_MAX, 0);
+        if (ret >= 0)
+            ret = av_read_frame(avf, pkt);
+        if (ret < 0) {
+            fprintf(stderr, "seek to %s: %s\n", *argv, av_err2str(ret));
+            return 1;
+        }
+        av_packet_unref(pkt);
+        snprintf(name, sizeof(name), "seek %s", *argv);
+        print_step(name, start);
+    }
+
+    av_dict_free(&opts);
+    av_packet_free(&pkt);
+    avformat_close_input(&avf);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the throughput of copying frames into buffers of a pool, and of
+ * reading them back by blocks as a decoder does for motion compensation, e.g.
+ * to compare pool flags on large frames:
+ *
+ *   frame_pool_bench -s 7680x4320 -p yuv420p10le -f 1
+ *
+ * The plane copy writes each row sequentially. The block pass reads 16x16
+ * blocks at pseudo-random positions, so each row of a block is in a different
+ * page when a row is larger than a page, which is where huge pages help.
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+
+#include "libavutil/buffer.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+#define NB_HELD 4
+#define BLOCK   16
+
+static void usage(int ret)
+{
+    fprintf(ret ? stderr : stdout,
+            "Usage: frame_pool_bench [-s size] [-p pix_fmt] [-n frames] [-f flags]\n"
+            "    -s size         frame size, default 7680x4320\n"
+            "    -p pix_fmt      pixel format, default yuv420p\n"
+            "    -n frames       number of frames, default 100\n"
+            "    -f flags        AV_BUFFER_POOL_FLAG_* of the pool, default 0\n"
+            );
+    exit(ret);
+}
+
+int main(int argc, char **argv)
+{
+    enum AVPixelFormat pix_fmt = AV_PIX_FMT_YUV420P;
+    int width = 7680, height = 4320, nb_frames = 100, flags = 0;
+    uint8_t *src[4], *dst[4], *block;
+    int src_linesize[4], dst_linesize[4];
+    AVBufferRef *held[NB_HELD] = { NULL };
+    const AVPixFmtDescriptor *desc;
+    AVBufferPool *pool;
+    int64_t copy_time = 0, block_time = 0, start;
+    int size, nb_blocks, opt, i, j;
+    unsigned sum = 0;
+    AVLFG lfg;
+
+    while ((opt = getopt(argc, argv, "hs:p:n:f:")) != -1) {
+        switch (opt) {
+        case 's':
+            if (av_parse_video_size(&width, &height, optarg) < 0) {
+                fprintf(stderr, "invalid size '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'p':
+            if ((pix_fmt = av_get_pix_fmt(optarg)) == AV_PIX_FMT_NONE) {
+                fprintf(stderr, "unknown pixel format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            nb_frames = atoi(optarg);
+            break;
+        case 'f':
+            flags = strtol(optarg, NULL, 0);
+            break;
+        case 'h':
+            usage(0);
+        default:
+            usage(1);
+        }
+    }
+
+    desc = av_pix_fmt_desc_get(pix_fmt);
+    if (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)) {
+        fprintf(stderr, "unsupported pixel format '%s'\n", desc->name);
+        return 1;
+    }
+    if ((size = av_image_get_buffer_size(pix_fmt, width, height, 64)) < 0 ||
+        av_image_alloc(src, src_linesize, width, height, pix_fmt, 64) < 0 ||
+        !(block = av_malloc(BLOCK * BLOCK * 8)) ||
+        !(pool = av_buffer_pool_init(size, NULL)))
+        return 1;
+    av_buffer_pool_set_flags(pool, flags);
+    for (i = 0; i < 4 && src[i]; i++)
+        memset(src[i], i + 1, src_linesize[i] * (i == 1 || i == 2 ?
+               AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height));
+
+    av_lfg_init(&lfg, 1);
+    nb_blocks = (width / BLOCK) * (height / BLOCK);
+
+    for (i = 0; i < nb_frames; i++) {
+        AVBufferRef **buf = &held[i % NB_HELD];
+        int bytes = av_image_get_linesize(pix_fmt, BLOCK, 0);
+
+        av_buffer_unref(buf);
+        if (!(*buf = av_buffer_pool_get(pool)))
+            return 1;
+        av_image_fill_arrays(dst, dst_linesize, (*buf)->data, pix_fmt,
+                             width, height, 64);
+
+        start = av_gettime_relative();
+        av_image_copy(dst, dst_linesize, (const uint8_t **)src, src_linesize,
+                      pix_fmt, width, height);
+        copy_time += av_gettime_relative() - start;
+
+        start = av_gettime_relative();
+        for (j = 0; j < nb_blocks; j++) {
+            int x = av_lfg_get(&lfg) % (width  - BLOCK + 1);
+            int y = av_lfg_get(&lfg) % (height - BLOCK + 1);
+
+            av_image_copy_plane(block, bytes,
+                                dst[0] + y * dst_linesize[0] +
+                                av_image_get_linesize(pix_fmt, x, 0),
+                                dst_linesize[0], bytes, BLOCK);
+            sum += block[j % (bytes * BLOCK)];
+        }
+        block_time += av_gettime_relative() - start;
+    }
+
+    printf("%dx%d %s, %d bytes per frame, flags %d\n",
+           width, height, desc->name, size, flags);
+    printf("plane copy  %8.1f MB/s\n",
+           (double)size * nb_frames / FFMAX(copy_time, 1));
+    printf("block read  %8.1f Mblocks/s (%u)\n",
+           (double)nb_blocks * nb_frames / FFMAX(block_time, 1), sum);
+
+    for (i = 0; i < NB_HELD; i++)
+        av_buffer_unref(&held[i]);
+    av_buffer_pool_uninit(&pool);
+    av_freep(&src[0]);
+    av_free(block);
+
+    return 0;
+}